@@ -19,6 +19,7 @@ SET(FLAGS_SSE41 "-msse4.1")
 SET(FLAGS_SSE42 "-msse4.2")
 SET(FLAGS_AVX   "-mavx -mvzeroupper")
 SET(FLAGS_AVX2  "-mavx2 -mvzeroupper")
+SET(FLAGS_F16C  "-mf16c")
 
 SET(CMAKE_CXX_COMPILER "clang++")
 SET(CMAKE_C_COMPILER "clang")
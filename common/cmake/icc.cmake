@@ -19,6 +19,7 @@ SET(FLAGS_SSE41 "-xsse41")
 SET(FLAGS_SSE42 "-xsse42")
 SET(FLAGS_AVX   "-xAVX")
 SET(FLAGS_AVX2  "-xCORE-AVX2")
+SET(FLAGS_F16C  "-xCORE-AVX-I")
 
 SET(CMAKE_CXX_COMPILER "icpc")
 SET(CMAKE_C_COMPILER "icc")
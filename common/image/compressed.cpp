@@ -0,0 +1,243 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "compressed.h"
+#include "sys/sysinfo.h"
+
+#include <cstring>
+#include <cmath>
+
+namespace embree
+{
+  /*! compiled with F16C in compressed_f16c.cpp, converts multiples of 4 pixels */
+  size_t float2halfRGBA_F16C(unsigned short* dst, const float* r, const float* g, const float* b, size_t n);
+
+  void float2halfRGBA(unsigned short* dst, const float* r, const float* g, const float* b, size_t n)
+  {
+    static const bool f16c = hasF16C();
+    size_t i = f16c ? float2halfRGBA_F16C(dst,r,g,b,n) : 0;
+    for (; i<n; i++) {
+      dst[4*i+0] = float2half(r[i]);
+      dst[4*i+1] = float2half(g[i]);
+      dst[4*i+2] = float2half(b[i]);
+      dst[4*i+3] = 0x3C00;
+    }
+  }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// BC1
+  ////////////////////////////////////////////////////////////////////////////////
+
+  ImageBC1::ImageBC1 (size_t width, size_t height, const std::string& name)
+    : Image(width,height,name), blocksX((width+3)/4), blocksY((height+3)/4)
+  {
+    blocks = (Block*) alignedMalloc(bytes());
+    memset(blocks,0,bytes());
+  }
+
+  ImageBC1::ImageBC1 (size_t width, size_t height, const Block* data, const std::string& name)
+    : Image(width,height,name), blocksX((width+3)/4), blocksY((height+3)/4)
+  {
+    blocks = (Block*) alignedMalloc(bytes());
+    memcpy(blocks,data,bytes());
+  }
+
+  ImageBC1::ImageBC1 (const Ref<Image>& image)
+    : Image(image->width,image->height,image->name), blocksX((image->width+3)/4), blocksY((image->height+3)/4)
+  {
+    blocks = (Block*) alignedMalloc(bytes());
+    Color texels[16];
+    for (size_t by=0; by<blocksY; by++) {
+      for (size_t bx=0; bx<blocksX; bx++) {
+        for (size_t i=0; i<16; i++) {
+          const Color4 c = image->get(min(4*bx+(i&3),width-1),min(4*by+(i>>2),height-1));
+          texels[i] = Color(c.r,c.g,c.b);
+        }
+        encode(texels,blocks[by*blocksX+bx]);
+      }
+    }
+  }
+
+  void ImageBC1::set(size_t x, size_t y, const Color4& c)
+  {
+    const size_t bx = x >> 2, by = y >> 2;
+    Color texels[16];
+    for (size_t i=0; i<16; i++) {
+      const Color4 t = get(min(4*bx+(i&3),width-1),min(4*by+(i>>2),height-1));
+      texels[i] = Color(t.r,t.g,t.b);
+    }
+    texels[((y & 3) << 2) + (x & 3)] = Color(c.r,c.g,c.b);
+    encode(texels,blocks[by*blocksX+bx]);
+  }
+
+  static __forceinline unsigned short toRGB565(const Color& c) {
+    const int r = int(clamp(c.r)*31.0f+0.5f), g = int(clamp(c.g)*63.0f+0.5f), b = int(clamp(c.b)*31.0f+0.5f);
+    return (unsigned short)((r << 11) | (g << 5) | b);
+  }
+
+  /*! fits the endpoints to the principal axis of the block colors */
+  void ImageBC1::encode(const Color texels[16], Block& block)
+  {
+    /* mean and covariance of the colors */
+    Color mean = zero;
+    for (size_t i=0; i<16; i++) mean += texels[i];
+    mean *= 1.0f/16.0f;
+    float cov[6] = { 0, 0, 0, 0, 0, 0 };
+    for (size_t i=0; i<16; i++) {
+      const Color d = texels[i]-mean;
+      cov[0] += d.r*d.r; cov[1] += d.r*d.g; cov[2] += d.r*d.b;
+      cov[3] += d.g*d.g; cov[4] += d.g*d.b; cov[5] += d.b*d.b;
+    }
+
+    /* principal axis by power iteration */
+    Color axis(1.0f,1.0f,1.0f);
+    for (size_t k=0; k<8; k++) {
+      const Color a(cov[0]*axis.r + cov[1]*axis.g + cov[2]*axis.b,
+                    cov[1]*axis.r + cov[3]*axis.g + cov[4]*axis.b,
+                    cov[2]*axis.r + cov[4]*axis.g + cov[5]*axis.b);
+      const float len = max(abs(a.r),abs(a.g),abs(a.b));
+      if (len == 0.0f) break;
+      axis = a*rcp(len);
+    }
+
+    /* endpoints at the extreme projections */
+    float tmin = float(pos_inf), tmax = float(neg_inf);
+    for (size_t i=0; i<16; i++) {
+      const Color d = texels[i]-mean;
+      const float t = d.r*axis.r + d.g*axis.g + d.b*axis.b;
+      tmin = min(tmin,t); tmax = max(tmax,t);
+    }
+    const float len2 = axis.r*axis.r + axis.g*axis.g + axis.b*axis.b;
+    if (len2 > 0.0f) { tmin *= rcp(len2); tmax *= rcp(len2); }
+    else tmin = tmax = 0.0f;
+    block.c0 = toRGB565(mean + tmax*axis);
+    block.c1 = toRGB565(mean + tmin*axis);
+    if (block.c0 < block.c1) std::swap(block.c0,block.c1);
+    block.indices = 0;
+    if (block.c0 == block.c1) return;
+
+    /* nearest palette entry per texel */
+    const Color c0 = rgb565(block.c0), c1 = rgb565(block.c1);
+    const Color palette[4] = { c0, c1, (2.0f/3.0f)*c0 + (1.0f/3.0f)*c1, (1.0f/3.0f)*c0 + (2.0f/3.0f)*c1 };
+    for (size_t i=0; i<16; i++) {
+      unsigned int best = 0; float bestDist = float(pos_inf);
+      for (unsigned int j=0; j<4; j++) {
+        const Color d = texels[i]-palette[j];
+        const float dist = d.r*d.r + d.g*d.g + d.b*d.b;
+        if (dist < bestDist) { best = j; bestDist = dist; }
+      }
+      block.indices |= best << (2*i);
+    }
+  }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// RGB9E5
+  ////////////////////////////////////////////////////////////////////////////////
+
+  ImageRGB9E5::ImageRGB9E5 (size_t width, size_t height, const std::string& name)
+    : Image(width,height,name)
+  {
+    data = (unsigned int*) alignedMalloc(bytes());
+    memset(data,0,bytes());
+  }
+
+  ImageRGB9E5::ImageRGB9E5 (size_t width, size_t height, const unsigned int* texels, const std::string& name)
+    : Image(width,height,name)
+  {
+    data = (unsigned int*) alignedMalloc(bytes());
+    memcpy(data,texels,bytes());
+  }
+
+  ImageRGB9E5::ImageRGB9E5 (const Ref<Image>& image)
+    : Image(image->width,image->height,image->name)
+  {
+    data = (unsigned int*) alignedMalloc(bytes());
+    for (size_t y=0; y<height; y++)
+      for (size_t x=0; x<width; x++)
+        data[y*width+x] = encode(image->get(x,y));
+  }
+
+  /*! encoding as specified by EXT_texture_shared_exponent */
+  unsigned int ImageRGB9E5::encode(const Color4& c)
+  {
+    const float maxValue = 65408.0f; // (511/512)*2^16
+    const float r = c.r > 0.0f ? min(c.r,maxValue) : 0.0f;
+    const float g = c.g > 0.0f ? min(c.g,maxValue) : 0.0f;
+    const float b = c.b > 0.0f ? min(c.b,maxValue) : 0.0f;
+    const float maxc = max(r,g,b);
+    if (maxc == 0.0f) return 0;
+
+    int e; frexpf(maxc,&e);
+    int exp = max(-16,e-1) + 16;
+    float scale = ldexpf(1.0f,exp-15-9);
+    if (int(maxc/scale+0.5f) == 512) { scale *= 2.0f; exp++; }
+
+    const unsigned int rm = min(int(r/scale+0.5f),511);
+    const unsigned int gm = min(int(g/scale+0.5f),511);
+    const unsigned int bm = min(int(b/scale+0.5f),511);
+    return ((unsigned int)exp << 27) | (bm << 18) | (gm << 9) | rm;
+  }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// Half
+  ////////////////////////////////////////////////////////////////////////////////
+
+  ImageHalf::ImageHalf (size_t width, size_t height, const std::string& name)
+    : Image(width,height,name)
+  {
+    data = (unsigned short*) alignedMalloc(bytes());
+    memset(data,0,bytes());
+  }
+
+  ImageHalf::ImageHalf (size_t width, size_t height, const unsigned short* texels, const std::string& name)
+    : Image(width,height,name)
+  {
+    data = (unsigned short*) alignedMalloc(bytes());
+    memcpy(data,texels,bytes());
+  }
+
+  ImageHalf::ImageHalf (const Ref<Image>& image)
+    : Image(image->width,image->height,image->name)
+  {
+    data = (unsigned short*) alignedMalloc(bytes());
+    for (size_t y=0; y<height; y++)
+      for (size_t x=0; x<width; x++)
+        set(x,y,image->get(x,y));
+  }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// Format selection
+  ////////////////////////////////////////////////////////////////////////////////
+
+  bool isCompressed(const Ref<Image>& image) {
+    return dynamic_cast<ImageBC1*>(image.ptr) || dynamic_cast<ImageRGB9E5*>(image.ptr) || dynamic_cast<ImageHalf*>(image.ptr);
+  }
+
+  Ref<Image> compressImage(const Ref<Image>& image, const std::string& format)
+  {
+    if (!image || format == "none" || isCompressed(image)) return image;
+    if (format == "auto") {
+      if (dynamic_cast<Image3c*>(image.ptr)) return new ImageBC1(image);
+      if (dynamic_cast<Image4c*>(image.ptr)) return image; // BC1 would drop the alpha channel
+      if (dynamic_cast<Image3f*>(image.ptr)) return new ImageRGB9E5(image);
+      return new ImageHalf(image);
+    }
+    if (format == "bc1"   ) return new ImageBC1(image);
+    if (format == "rgb9e5") return new ImageRGB9E5(image);
+    if (format == "half"  ) return new ImageHalf(image);
+    throw std::runtime_error("unknown image compression: "+format);
+  }
+}
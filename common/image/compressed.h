@@ -0,0 +1,210 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "image.h"
+
+namespace embree
+{
+  /*! converts a half precision float to float */
+  __forceinline float half2float(const unsigned short h)
+  {
+    union { unsigned int u; float f; } o;
+    const unsigned int shifted = (h & 0x7fff) << 13;
+    const unsigned int exp = shifted & 0x0f800000;
+    o.u = shifted + ((127-15) << 23);
+    if      (exp == 0x0f800000) o.u += (128-16) << 23;                   // inf and nan
+    else if (exp == 0)        { o.u += 1 << 23; o.f -= 6.10351562e-05f; } // denormals
+    o.u |= (h & 0x8000) << 16;
+    return o.f;
+  }
+
+  /*! converts a float to half precision with rounding to nearest */
+  __forceinline unsigned short float2half(const float f)
+  {
+    union { unsigned int u; float f; } in, denormMagic;
+    denormMagic.u = ((127-15) + (23-10) + 1) << 23;
+    in.f = f;
+    const unsigned int sign = in.u & 0x80000000;
+    in.u ^= sign;
+    unsigned short o;
+    if (in.u >= (127+16) << 23) o = in.u > (255u << 23) ? 0x7e00 : 0x7c00; // inf and nan
+    else if (in.u < (113 << 23)) { in.f += denormMagic.f; o = (unsigned short)(in.u - denormMagic.u); }
+    else {
+      const unsigned int odd = (in.u >> 13) & 1;
+      in.u += ((15-127) << 23) + 0xfff + odd;
+      o = (unsigned short)(in.u >> 13);
+    }
+    return o | (unsigned short)(sign >> 16);
+  }
+
+  /*! converts n pixels given as arrays of red, green, and blue values
+   *  to half precision RGBA pixels with alpha set to one, uses the F16C
+   *  instructions if the CPU supports them */
+  void float2halfRGBA(unsigned short* dst, const float* r, const float* g, const float* b, size_t n);
+
+  /*! LDR image compressed into BC1 blocks. Each block stores 4x4
+   *  texels as two RGB565 endpoints and a 2 bit palette index per
+   *  texel, which is 4 bits per texel. Alpha is always one. */
+  class ImageBC1 : public Image 
+  {
+  public:
+
+    /*! BC1 block of 4x4 texels */
+    struct Block {
+      unsigned short c0, c1;  //!< RGB565 endpoints
+      unsigned int indices;   //!< 2 bit palette index per texel, row major
+    };
+
+    /*! compresses an image */
+    ImageBC1 (const Ref<Image>& image);
+
+    /*! creates a black image */
+    ImageBC1 (size_t width, size_t height, const std::string& name = "");
+
+    /*! initialize image from block data */
+    ImageBC1 (size_t width, size_t height, const Block* blocks, const std::string& name = "");
+
+    ~ImageBC1 () { alignedFree(blocks); }
+
+    /*! decodes a texel */
+    __forceinline Color4 get(size_t x, size_t y) const 
+    {
+      const Block& b = blocks[(y >> 2)*blocksX + (x >> 2)];
+      const unsigned int i = (b.indices >> (2*(((y & 3) << 2) + (x & 3)))) & 3;
+      const Color c0 = rgb565(b.c0), c1 = rgb565(b.c1);
+      Color c;
+      if (b.c0 > b.c1) {
+        if      (i == 0) c = c0;
+        else if (i == 1) c = c1;
+        else if (i == 2) c = (2.0f/3.0f)*c0 + (1.0f/3.0f)*c1;
+        else             c = (1.0f/3.0f)*c0 + (2.0f/3.0f)*c1;
+      } else {
+        if      (i == 0) c = c0;
+        else if (i == 1) c = c1;
+        else if (i == 2) c = 0.5f*(c0+c1);
+        else             c = Color(zero);
+      }
+      return Color4(c.r,c.g,c.b,1.0f);
+    }
+
+    /*! sets a texel by recompressing its block, which is slow */
+    void set(size_t x, size_t y, const Color4& c);
+
+    size_t bytes() const { return blocksX*blocksY*sizeof(Block); }
+
+    /*! returns the block data */
+    __forceinline void* ptr() { return (void*)blocks; }
+
+  private:
+    static __forceinline Color rgb565(const unsigned short c) {
+      return Color(float(c >> 11)*(1.0f/31.0f),float((c >> 5) & 63)*(1.0f/63.0f),float(c & 31)*(1.0f/31.0f));
+    }
+    static void encode(const Color texels[16], Block& block);
+
+  public:
+    size_t blocksX, blocksY;  //!< number of blocks in x and y
+  private:
+    Block* blocks;            //!< blocks in row major order
+  };
+
+  /*! HDR image with RGB9E5 texels. The three channels share one 5 bit
+   *  exponent and have 9 bit mantissas, which is 32 bits per texel.
+   *  Negative values are clamped to zero, alpha is always one. */
+  class ImageRGB9E5 : public Image
+  {
+  public:
+
+    /*! compresses an image */
+    ImageRGB9E5 (const Ref<Image>& image);
+
+    /*! creates a black image */
+    ImageRGB9E5 (size_t width, size_t height, const std::string& name = "");
+
+    /*! initialize image from texel data */
+    ImageRGB9E5 (size_t width, size_t height, const unsigned int* data, const std::string& name = "");
+
+    ~ImageRGB9E5 () { alignedFree(data); }
+
+    __forceinline Color4 get(size_t x, size_t y) const {
+      const unsigned int c = data[y*width+x];
+      union { unsigned int u; float f; } scale; 
+      scale.u = ((c >> 27) + 127 - 15 - 9) << 23; // 2^(e-15-9)
+      return Color4(float(c & 511)*scale.f,float((c >> 9) & 511)*scale.f,float((c >> 18) & 511)*scale.f,1.0f);
+    }
+
+    __forceinline void set(size_t x, size_t y, const Color4& c) { 
+      data[y*width+x] = encode(c); 
+    }
+
+    size_t bytes() const { return width*height*sizeof(unsigned int); }
+
+    /*! returns the texel data */
+    __forceinline void* ptr() { return (void*)data; }
+
+  private:
+    static unsigned int encode(const Color4& c);
+
+  private:
+    unsigned int* data;
+  };
+
+  /*! HDR image with half precision RGBA texels, 64 bits per texel. */
+  class ImageHalf : public Image
+  {
+  public:
+
+    /*! converts an image */
+    ImageHalf (const Ref<Image>& image);
+
+    /*! creates a black image */
+    ImageHalf (size_t width, size_t height, const std::string& name = "");
+
+    /*! initialize image from texel data */
+    ImageHalf (size_t width, size_t height, const unsigned short* data, const std::string& name = "");
+
+    ~ImageHalf () { alignedFree(data); }
+
+    __forceinline Color4 get(size_t x, size_t y) const {
+      const unsigned short* c = &data[4*(y*width+x)];
+      return Color4(half2float(c[0]),half2float(c[1]),half2float(c[2]),half2float(c[3]));
+    }
+
+    __forceinline void set(size_t x, size_t y, const Color4& c) { 
+      unsigned short* d = &data[4*(y*width+x)];
+      d[0] = float2half(c.r); d[1] = float2half(c.g); d[2] = float2half(c.b); d[3] = float2half(c.a);
+    }
+
+    size_t bytes() const { return 4*width*height*sizeof(unsigned short); }
+
+    /*! returns the texel data */
+    __forceinline void* ptr() { return (void*)data; }
+
+  private:
+    unsigned short* data;
+  };
+
+  /*! Converts an image into a compressed storage format: "bc1",
+   *  "rgb9e5" or "half". "auto" selects bc1 for 8 bit RGB images,
+   *  rgb9e5 for float RGB images and half for float RGBA images, and
+   *  keeps 8 bit RGBA images uncompressed to preserve their alpha
+   *  channel. "none" returns the image unchanged. */
+  Ref<Image> compressImage(const Ref<Image>& image, const std::string& format);
+
+  /*! Returns true for images in one of the compressed storage formats. */
+  bool isCompressed(const Ref<Image>& image);
+}
@@ -0,0 +1,40 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include <cstddef>
+#include <immintrin.h>
+
+/*! This file is compiled with F16C enabled and only called after
+ *  checking for F16C support at runtime, thus it must not include
+ *  headers with inline functions shared with other files. */
+
+namespace embree
+{
+  size_t float2halfRGBA_F16C(unsigned short* dst, const float* r, const float* g, const float* b, size_t n)
+  {
+    size_t i=0;
+    for (; i+4<=n; i+=4) 
+    {
+      __m128 c0 = _mm_loadu_ps(r+i), c1 = _mm_loadu_ps(g+i), c2 = _mm_loadu_ps(b+i), c3 = _mm_set1_ps(1.0f);
+      _MM_TRANSPOSE4_PS(c0,c1,c2,c3);
+      const __m128i h0 = _mm_cvtps_ph(c0,_MM_FROUND_TO_NEAREST_INT), h1 = _mm_cvtps_ph(c1,_MM_FROUND_TO_NEAREST_INT);
+      const __m128i h2 = _mm_cvtps_ph(c2,_MM_FROUND_TO_NEAREST_INT), h3 = _mm_cvtps_ph(c3,_MM_FROUND_TO_NEAREST_INT);
+      _mm_storeu_si128((__m128i*)(dst+4*i+0),_mm_unpacklo_epi64(h0,h1));
+      _mm_storeu_si128((__m128i*)(dst+4*i+8),_mm_unpacklo_epi64(h2,h3));
+    }
+    return i;
+  }
+}
@@ -17,11 +17,13 @@
 #ifdef USE_OPENEXR
 
 #include "image/image.h"
+#include "image/compressed.h"
 
 /* include OpenEXR headers */
 #ifdef __WIN32__
 #include <ImfRgbaFile.h>
 #include <ImfArray.h>
+#include <ImfThreading.h>
 #pragma comment (lib, "Half.lib")
 #pragma comment (lib, "Iex.lib")
 #pragma comment (lib, "IlmImf.lib")
@@ -31,6 +33,7 @@
 #else
 #include <ImfRgbaFile.h>
 #include <ImfArray.h>
+#include <ImfThreading.h>
 #endif
 
 namespace embree
@@ -69,20 +72,53 @@ namespace embree
     return img;
   }
 
+  /*! converts the rows of one strip to half precision RGBA */
+  struct ConvertToRgba
+  {
+    ConvertToRgba (const Ref<Image>& img, Imf::Array2D<Imf::Rgba>& pixels) : img(img), pixels(pixels) {}
+
+    static void convert(void* ptr, size_t strip, size_t numStrips)
+    {
+      ConvertToRgba* This = (ConvertToRgba*) ptr;
+      const Ref<Image>& img = This->img;
+      for (size_t y=(strip+0)*img->height/numStrips; y<(strip+1)*img->height/numStrips; y++) {
+        for (size_t x=0; x<img->width; x++) {
+          const Color4 c = img->get(x,y);
+          This->pixels[y][x] = Imf::Rgba(c.r,c.g,c.b,c.a);
+        }
+      }
+    }
+
+    const Ref<Image>& img;
+    Imf::Array2D<Imf::Rgba>& pixels;
+  };
+
+  /*! write the pixels, OpenEXR compresses the chunks of scanlines in parallel on its own thread pool */
+  static void writeExr(const FileName& filename, const Imf::Rgba* pixels, size_t width, size_t height)
+  {
+    const int numThreads = (int) getNumImageStrips();
+    if (numThreads > 1 && Imf::globalThreadCount() != numThreads) 
+      Imf::setGlobalThreadCount(numThreads);
+
+    Imf::RgbaOutputFile file(filename.c_str(), width, height, Imf::WRITE_RGBA);
+    file.setFrameBuffer(pixels, 1, width);
+    file.writePixels(height);
+  }
+
   /*! store an EXR file to disk */
   void storeExr(const Ref<Image>& img, const FileName& filename)
   {
-    Imf::Array2D<Imf::Rgba> pixels(img->height,img->width);
-    for (size_t y=0; y<img->height; y++) {
-      for (size_t x=0; x<img->width; x++) {
-        const Color4 c = img->get(x,y);
-        pixels[y][x] = Imf::Rgba(c.r,c.g,c.b,c.a);
-      }
+    /*! half precision RGBA texels have the layout of Imf::Rgba and are written without conversion */
+    if (ImageHalf* himg = dynamic_cast<ImageHalf*>(img.ptr)) {
+      writeExr(filename, (const Imf::Rgba*)himg->ptr(), img->width, img->height);
+      return;
     }
 
-    Imf::RgbaOutputFile file(filename.c_str(), img->width, img->height, Imf::WRITE_RGBA);
-    file.setFrameBuffer(&pixels[0][0], 1, img->width);
-    file.writePixels(img->height);
+    /*! convert strips of scanlines in parallel */
+    Imf::Array2D<Imf::Rgba> pixels(img->height,img->width);
+    ConvertToRgba convert(img,pixels);
+    parallelStrips(min(getNumImageStrips(),max(img->height,size_t(1))),ConvertToRgba::convert,&convert);
+    writeExr(filename, &pixels[0][0], img->width, img->height);
   }
 }
 
@@ -15,9 +15,17 @@
 // ======================================================================== //
 
 #include "image.h"
+#include "tiled.h"
 #include "sys/stl/string.h"
+#include "sys/sysinfo.h"
+#include "sys/thread.h"
+#include "sys/sync/mutex.h"
+#include "sys/sync/condition.h"
+#include "sys/taskscheduler.h"
 
 #include <map>
+#include <list>
+#include <deque>
 #include <iostream>
 
 namespace embree
@@ -33,7 +41,6 @@ namespace embree
     if (ext == "bmp" ) return loadMagick(fileName);
     if (ext == "gif" ) return loadMagick(fileName);
     if (ext == "png" ) return loadMagick(fileName);
-    if (ext == "tga" ) return loadMagick(fileName);
     if (ext == "tif" ) return loadMagick(fileName);
     if (ext == "tiff") return loadMagick(fileName);
 #endif
@@ -42,6 +49,8 @@ namespace embree
 #endif
     if (ext == "pfm" ) return loadPFM(fileName);
     if (ext == "ppm" ) return loadPPM(fileName);
+    if (ext == "tga" ) return loadTga(fileName);
+    if (ext == "etx" ) return loadTiled(fileName);
     throw std::runtime_error("image format " + ext + " not supported");
   }
   catch (const std::exception& e) {
@@ -49,18 +58,275 @@ namespace embree
     return null;
   }
 
+  /*! LRU cache of decoded images, shared by all threads */
+  struct ImageCache
+  {
+    struct Entry {
+      Ref<ImageFuture> image;                //!< image or image being decoded
+      std::list<std::string>::iterator lru;  //!< position in LRU list
+      size_t bytes;                          //!< bytes of the decoded image, 0 while decoding
+    };
+
+    ImageCache () : bytes(0), maxBytes(1024*1024*1024) {}
+
+    /*! looks up an image and creates a new entry if not found, returns true if the entry got created */
+    bool lookup(const std::string& fileName, Ref<ImageFuture>& image)
+    {
+      Lock<MutexSys> lock(mutex);
+      std::map<std::string,Entry>::iterator i = entries.find(fileName);
+      if (i != entries.end()) {
+        lru.splice(lru.begin(),lru,i->second.lru);
+        image = i->second.image;
+        return false;
+      }
+      lru.push_front(fileName);
+      Entry& entry = entries[fileName];
+      entry.image = image = new ImageFuture(fileName);
+      entry.lru = lru.begin();
+      entry.bytes = 0;
+      return true;
+    }
+
+    /*! accounts for a decoded image and evicts least recently used images if over budget */
+    void decoded(const Ref<ImageFuture>& image, const Ref<Image>& img)
+    {
+      Lock<MutexSys> lock(mutex);
+      std::map<std::string,Entry>::iterator i = entries.find(image->fileName);
+      if (i == entries.end() || i->second.image != image) return;
+      if (!img) { lru.erase(i->second.lru); entries.erase(i); return; }
+      i->second.bytes = img->bytes();
+      bytes += i->second.bytes;
+      evict();
+    }
+
+    /*! evicts decoded images until the cache fits into its budget */
+    void evict()
+    {
+      std::list<std::string>::iterator l = lru.end();
+      while (bytes > maxBytes && l != lru.begin()) {
+        std::map<std::string,Entry>::iterator i = entries.find(*--l);
+        if (i->second.bytes == 0) continue; // still decoding
+        bytes -= i->second.bytes;
+        l = lru.erase(l);
+        entries.erase(i);
+      }
+    }
+
+    /*! removes an image from the cache, threads holding its future still get the image */
+    void remove(const std::string& fileName)
+    {
+      Lock<MutexSys> lock(mutex);
+      std::map<std::string,Entry>::iterator i = entries.find(fileName);
+      if (i == entries.end()) return;
+      bytes -= i->second.bytes;
+      lru.erase(i->second.lru);
+      entries.erase(i);
+    }
+
+    void setMaxBytes(size_t maxBytes) {
+      Lock<MutexSys> lock(mutex);
+      this->maxBytes = maxBytes;
+      evict();
+    }
+
+    void clear() {
+      Lock<MutexSys> lock(mutex);
+      entries.clear(); lru.clear(); bytes = 0;
+    }
+
+  private:
+    MutexSys mutex;
+    std::map<std::string,Entry> entries;   //!< cached images by filename
+    std::list<std::string> lru;            //!< filenames, most recently used first
+    size_t bytes;                          //!< bytes of all decoded images in the cache
+    size_t maxBytes;                       //!< byte budget of the cache
+  };
+
+  /*! never destroyed, as loader threads may still access it at exit */
+  static ImageCache& imageCache() {
+    static ImageCache* cache = new ImageCache;
+    return *cache;
+  }
+
+  /*! decodes an image and passes it to all waiting threads */
+  static void decodeImage(Ref<ImageFuture> image, bool cache)
+  {
+    Ref<Image> img = loadImageFromDisk(image->fileName);
+    if (cache) imageCache().decoded(image,img);
+    image->set(img);
+  }
+
+  /*! pool of threads decoding images in the background */
+  struct ImageLoaderThreads
+  {
+    struct Job {
+      Job (const Ref<ImageFuture>& image, bool cache) : image(image), cache(cache) {}
+      Ref<ImageFuture> image;
+      bool cache;
+    };
+
+    ImageLoaderThreads () 
+    {
+      size_t numThreads = min(getNumberOfLogicalThreads(),size_t(4));
+      for (size_t i=0; i<numThreads; i++)
+        threads.push_back(createThread(threadFunction,this));
+    }
+
+    void add(const Ref<ImageFuture>& image, bool cache)
+    {
+      Lock<MutexSys> lock(mutex);
+      jobs.push_back(Job(image,cache));
+      condition.broadcast();
+    }
+
+    static void threadFunction(void* ptr) 
+    {
+      ImageLoaderThreads* This = (ImageLoaderThreads*) ptr;
+      while (true) 
+      {
+        This->mutex.lock();
+        while (This->jobs.empty()) This->condition.wait(This->mutex);
+        Job job = This->jobs.front(); This->jobs.pop_front();
+        This->mutex.unlock();
+        decodeImage(job.image,job.cache);
+      }
+    }
+
+  private:
+    MutexSys mutex;
+    ConditionSys condition;
+    std::deque<Job> jobs;
+    std::vector<thread_t> threads;
+  };
+
+  /*! never destroyed, as the threads block on the condition until exit */
+  static ImageLoaderThreads& imageLoaderThreads() {
+    static ImageLoaderThreads* threads = new ImageLoaderThreads;
+    return *threads;
+  }
+
   /*! loads an image from a file with auto-detection of format */
   Ref<Image> loadImage(const FileName& fileName, bool cache)
   {
-    static std::map<std::string,Ref<Image> > image_cache;
-
     if (!cache)
       return loadImageFromDisk(fileName);
 
-    if (image_cache.find(fileName) == image_cache.end())
-      image_cache[fileName] = loadImageFromDisk(fileName);
+    Ref<ImageFuture> image;
+    if (imageCache().lookup(fileName,image))
+      decodeImage(image,true);
+
+    return image->get();
+  }
+
+  /*! loads an image from a file in the background */
+  Ref<ImageFuture> loadImageAsync(const FileName& fileName, bool cache)
+  {
+    Ref<ImageFuture> image;
+    if (!cache) image = new ImageFuture(fileName);
+    else if (!imageCache().lookup(fileName,image)) return image;
+    imageLoaderThreads().add(image,cache);
+    return image;
+  }
+
+  void setImageCacheSize(size_t bytes) {
+    imageCache().setMaxBytes(bytes);
+  }
+
+  void evictImage(const FileName& fileName) {
+    imageCache().remove(fileName);
+  }
+
+  void clearImageCache() {
+    imageCache().clear();
+  }
+
+  /*! task executing the strips of an image encoder */
+  struct StripTask
+  {
+    StripTask (StripFunction func, void* data) : func(func), data(data) {}
+
+    TASK_RUN_FUNCTION(StripTask,run);
+
+    StripFunction func;
+    void* data;
+  };
+
+  void StripTask::run(size_t threadIndex, size_t threadCount, size_t taskIndex, size_t taskCount, TaskScheduler::Event* event) {
+    func(data,taskIndex,taskCount);
+  }
+
+  size_t getNumImageStrips() {
+    return TaskScheduler::instance ? TaskScheduler::getNumThreads() : 1;
+  }
+
+  void parallelStrips(size_t numStrips, StripFunction func, void* data)
+  {
+    if (numStrips <= 1 || !TaskScheduler::instance) {
+      for (size_t i=0; i<numStrips; i++) func(data,i,numStrips);
+      return;
+    }
+    StripTask strips(func,data);
+    TaskScheduler::EventSync event;
+    TaskScheduler::Task task(&event,StripTask::_run,&strips,numStrips,NULL,NULL,"image::strips");
+    TaskScheduler::addTask(-1,TaskScheduler::GLOBAL_FRONT,&task);
+    event.sync();
+  }
+
+  void downsample2x2(const Col4f* src, size_t w, size_t h, Col4f* dst, size_t dw, size_t dh)
+  {
+    for (size_t y=0; y<dh; y++) {
+      const size_t y0 = min(2*y,h-1), y1 = min(2*y+1,h-1);
+      for (size_t x=0; x<dw; x++) {
+        const size_t x0 = min(2*x,w-1), x1 = min(2*x+1,w-1);
+        const Col4f& c00 = src[y0*w+x0], c01 = src[y0*w+x1];
+        const Col4f& c10 = src[y1*w+x0], c11 = src[y1*w+x1];
+        dst[y*dw+x] = Col4f(0.25f*(c00.r+c01.r+c10.r+c11.r),0.25f*(c00.g+c01.g+c10.g+c11.g),
+                            0.25f*(c00.b+c01.b+c10.b+c11.b),0.25f*(c00.a+c01.a+c10.a+c11.a));
+      }
+    }
+  }
 
-    return image_cache[fileName];
+  /*! converts the rows of one strip to RGB8 or BGR8 */
+  struct ConvertToRGB8
+  {
+    ConvertToRGB8 (const Ref<Image>& img, unsigned char* rgb, bool bgr) : img(img), rgb(rgb), bgr(bgr) {}
+
+    static void convert(void* ptr, size_t strip, size_t numStrips)
+    {
+      ConvertToRGB8* This = (ConvertToRGB8*) ptr;
+      const Ref<Image>& img = This->img;
+      const size_t y0 = (strip+0)*img->height/numStrips;
+      const size_t y1 = (strip+1)*img->height/numStrips;
+      const size_t r = This->bgr ? 2 : 0, b = 2-r;
+
+      /* RGB8 images only get copied */
+      if (!This->bgr) {
+        if (Ref<Image3c> cimg = img.dynamicCast<Image3c>()) {
+          memcpy(This->rgb+3*y0*img->width,(unsigned char*)cimg->ptr()+3*y0*img->width,3*(y1-y0)*img->width);
+          return;
+        }
+      }
+
+      for (size_t y=y0; y<y1; y++) {
+        unsigned char* row = This->rgb+3*y*img->width;
+        for (size_t x=0; x<img->width; x++) {
+          const Color4 c = img->get(x,y);
+          row[3*x+r] = (unsigned char)(clamp(c.r)*255.0f);
+          row[3*x+1] = (unsigned char)(clamp(c.g)*255.0f);
+          row[3*x+b] = (unsigned char)(clamp(c.b)*255.0f);
+        }
+      }
+    }
+
+    const Ref<Image>& img;
+    unsigned char* rgb;
+    bool bgr;
+  };
+
+  void convertToRGB8(const Ref<Image>& img, unsigned char* rgb, bool bgr)
+  {
+    ConvertToRGB8 convert(img,rgb,bgr);
+    parallelStrips(min(getNumImageStrips(),max(img->height,size_t(1))),ConvertToRGB8::convert,&convert);
   }
 
   /*! stores an image to file with auto-detection of format */
@@ -83,6 +349,7 @@ namespace embree
     if (ext == "pfm" ) { storePFM(img, fileName);  return; }
     if (ext == "ppm" ) { storePPM(img, fileName);  return; }
     if (ext == "tga" ) { storeTga(img, fileName);  return; }
+    if (ext == "etx" ) { storeTiled(img, fileName);  return; }
     throw std::runtime_error("image format " + ext + " not supported");
   }
   catch (const std::exception& e) {
@@ -22,6 +22,7 @@
 #include "sys/platform.h"
 #include "sys/ref.h"
 #include "sys/filename.h"
+#include "sys/sync/event.h"
 #include "math/color.h"
 
 namespace embree
@@ -34,6 +35,7 @@ namespace embree
     virtual Color4 get(size_t x, size_t y) const = 0;
     virtual void   set(size_t x, size_t y, const Color4& c) = 0;
     void set(size_t x, size_t y, const Color& c) { set(x,y,Color4(c.r,c.g,c.b,1.0f)); }
+    virtual size_t bytes() const = 0;
   public:
     size_t width,height;
     std::string name;
@@ -88,11 +90,20 @@ namespace embree
       c.set(data[y*width+x]); 
     }
 
+    /*! returns number of bytes used to store the pixels */
+    size_t bytes() const {
+      return width*height*sizeof(T);
+    }
+
     /*! returns data pointer of image */
     __forceinline void* ptr() {
       return (void*)data;
     }
 
+    __forceinline const void* ptr() const {
+      return (const void*)data;
+    }
+
     /*! returns and forgets about data pointer of image */
     __forceinline void* steal_ptr() {
       T* ptr = data;
@@ -110,6 +121,44 @@ namespace embree
   typedef ImageT<Col4c> Image4c;
   typedef ImageT<Col4f> Image4f;
   
+  /*! Handle to an image that gets decoded asynchronously. */
+  class ImageFuture : public RefCount {
+    ALIGNED_CLASS;
+  public:
+    ImageFuture (const FileName& fileName) : fileName(fileName), done(false) {}
+
+    /*! returns true if decoding has finished */
+    bool ready() const { return done; }
+
+    /*! waits for decoding to finish and returns the image */
+    Ref<Image> get() { event.wait(); return image; }
+
+    /*! sets the decoded image and wakes up all waiting threads */
+    void set(const Ref<Image>& img) { image = img; done = true; event.signal(); }
+
+  public:
+    FileName fileName;  //!< file the image gets decoded from
+  private:
+    Ref<Image> image;   //!< decoded image, NULL on failure
+    volatile bool done; //!< true when decoding finished
+    EventSys event;     //!< signalled when decoding finished
+  };
+
+  /*! Function processing one of numStrips horizontal strips of an image. */
+  typedef void (*StripFunction)(void* data, size_t strip, size_t numStrips);
+
+  /*! Returns the number of strips the image encoders split their work into. */
+  size_t getNumImageStrips();
+
+  /*! Executes the strip function for all strips in parallel on the task scheduler, or serially if no scheduler got created. */
+  void parallelStrips(size_t numStrips, StripFunction func, void* data);
+
+  /*! Box filters a w x h image by 2x2 into the next coarser mip-map level of size dw x dh, clamping at the border. */
+  void downsample2x2(const Col4f* src, size_t w, size_t h, Col4f* dst, size_t dw, size_t dh);
+
+  /*! Converts an image to packed 8 bit RGB, or BGR if requested, converting strips of rows in parallel. */
+  void convertToRGB8(const Ref<Image>& img, unsigned char* rgb, bool bgr = false);
+
   /*! Generate a JPEG encoded image from a RGB8 buffer in memory. */
   void encodeRGB8_to_JPEG(unsigned char *image, size_t width, size_t height, unsigned char **encoded, size_t *capacity);
 
@@ -119,6 +168,18 @@ namespace embree
   /*! Loads image from file. Format is auto detected. */
   Ref<Image> loadImage(const FileName& filename, bool cache = false);
 
+  /*! Loads image from file on a background thread. Format is auto detected. */
+  Ref<ImageFuture> loadImageAsync(const FileName& filename, bool cache = false);
+
+  /*! Sets the maximal number of bytes of decoded images kept in the image cache. */
+  void setImageCacheSize(size_t bytes);
+
+  /*! Removes an image from the image cache, e.g. once a device has taken its own copy. */
+  void evictImage(const FileName& fileName);
+
+  /*! Removes all images from the image cache. */
+  void clearImageCache();
+
   /*! Loads image from JPEG file. */
   Ref<Image> loadJPEG(const FileName& fileName);
 
@@ -134,6 +195,9 @@ namespace embree
   /*! Loads image from PPM file. */
   Ref<Image> loadPPM(const FileName& fileName);
 
+  /*! Loads image from TGA file. */
+  Ref<Image> loadTga(const FileName& fileName);
+
   /*! Loads image from TIFF file. */
 //Ref<Image> loadTIFF(const FileName& fileName);
   
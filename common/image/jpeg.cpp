@@ -19,6 +19,9 @@
 #include "image/image.h"
 #include "jpeglib.h"
 
+#include <vector>
+#include <cstring>
+
 namespace embree
 {
 
@@ -62,10 +65,11 @@ namespace embree
 
     }
 
-    void encodeRGB8_to_JPEG(unsigned char *image, size_t width, size_t height, unsigned char **encoded, size_t *capacity)
-    {
+#if JPEG_LIB_VERSION >= 80 || defined(MEM_SRCDST_SUPPORTED)
 
-#if JPEG_LIB_VERSION >= 80
+    /*! Compresses a RGB8 buffer into a complete JPEG stream in memory, emitting restart markers if requested. */
+    static void compressToMemory(const unsigned char *image, size_t width, size_t height, int quality, unsigned int restartInterval, std::vector<unsigned char> &out)
+    {
 
         /*! Compression parameters and scratch space pointers (allocated by the library). */
         struct jpeg_compress_struct cinfo;
@@ -82,17 +86,105 @@ namespace embree
         /*! Fill in a sensible set of defaults. */
         jpeg_set_defaults(&cinfo);
 
-        /*! Set the image quality. */
-        jpeg_set_quality(&cinfo, 90, TRUE);
+        /*! Set the image quality and the number of MCUs between restart markers. */
+        jpeg_set_quality(&cinfo, quality, TRUE);  cinfo.restart_interval = restartInterval;
 
-        /*! Specify the data source. */
-        jpeg_mem_dest(&cinfo, encoded, capacity);
+        /*! Specify the data destination (allocated by the library). */
+        unsigned char *buffer = NULL;  unsigned long bytes = 0;  jpeg_mem_dest(&cinfo, &buffer, &bytes);
 
-        /*! Compress and write the image into the target buffer. */
-        compress(&cinfo, image);
+        /*! Compress the image into the library buffer. */
+        compress(&cinfo, (unsigned char *) image);
 
-        /*! At this point 'jerror.num_warnings' could be checked for corrupt-data warnings. */
-        jpeg_destroy_compress(&cinfo);
+        /*! Clean up. */
+        jpeg_destroy_compress(&cinfo);  out.assign(buffer, buffer + bytes);  free(buffer);
+
+    }
+
+    /*! Returns the offset of the entropy coded data behind the SOS marker segment, and optionally the offset of the image height in the SOF marker segment. */
+    static size_t findScanData(const std::vector<unsigned char> &jpeg, size_t *heightOffset)
+    {
+
+        /*! Walk the marker segments following the SOI marker. */
+        for (size_t i=2 ; i + 4 <= jpeg.size() ; ) {
+            if (jpeg[i] != 0xFF) throw std::runtime_error("invalid JPEG marker");
+            const unsigned char marker = jpeg[i + 1];  const size_t length = (jpeg[i + 2] << 8) | jpeg[i + 3];
+            if (marker >= 0xC0 && marker <= 0xC2 && heightOffset) *heightOffset = i + 5;
+            i += 2 + length;  if (marker == 0xDA) return(i);
+        }
+        throw std::runtime_error("JPEG stream without scan data");
+
+    }
+
+    /*! Horizontal strips of MCU rows that get compressed independently. */
+    struct JPEGStrips
+    {
+
+        JPEGStrips(const unsigned char *image, size_t width, size_t height, int quality, size_t stripRows, unsigned int restartInterval, size_t numStrips)
+            : image(image), width(width), height(height), quality(quality), stripRows(stripRows), restartInterval(restartInterval), strips(numStrips) {}
+
+        /*! Compresses the rows of one strip into a JPEG stream of its own. */
+        static void encode(void *ptr, size_t strip, size_t numStrips)
+        {
+            JPEGStrips *This = (JPEGStrips *) ptr;
+            const size_t y0 = strip * This->stripRows, y1 = min(y0 + This->stripRows, This->height);
+            compressToMemory(This->image + 3 * y0 * This->width, This->width, y1 - y0, This->quality, This->restartInterval, This->strips[strip]);
+        }
+
+        const unsigned char *image;  size_t width, height;  int quality;
+        size_t stripRows;  unsigned int restartInterval;
+        std::vector<std::vector<unsigned char> > strips;
+
+    };
+
+    /*! Compresses strips of MCU rows in parallel and joins their entropy coded data with restart markers into a single baseline JPEG stream. */
+    static void encodeJPEG(const unsigned char *image, size_t width, size_t height, int quality, std::vector<unsigned char> &out)
+    {
+
+        /*! The default parameters subsample chroma by 2x2, thus an MCU covers 16x16 pixels. */
+        const size_t mcusPerRow = (width + 15) / 16, mcuRows = (height + 15) / 16;
+
+        /*! One strip per thread, but restart intervals are limited to 16 bit. */
+        const size_t numThreads = max(min(getNumImageStrips(), mcuRows), size_t(1));
+        const size_t stripMCURows = max(min((mcuRows + numThreads - 1) / numThreads, size_t(65535) / max(mcusPerRow, size_t(1))), size_t(1));
+        const size_t numStrips = (mcuRows + stripMCURows - 1) / stripMCURows;
+
+        /*! Small images and single threaded encoding produce a stream without restart markers. */
+        if (numStrips <= 1) { compressToMemory(image, width, height, quality, 0, out);  return; }
+
+        /*! Each strip holds exactly one restart interval, thus the library never emits restart markers inside a strip. */
+        JPEGStrips strips(image, width, height, quality, 16 * stripMCURows, (unsigned int)(mcusPerRow * stripMCURows), numStrips);
+        parallelStrips(numStrips, JPEGStrips::encode, &strips);
+
+        /*! The headers of all strips match except for the image height, thus take the header of the first strip and patch the height. */
+        size_t heightOffset = 0;  size_t begin = findScanData(strips.strips[0], &heightOffset);
+        out.assign(strips.strips[0].begin(), strips.strips[0].begin() + begin);
+        out[heightOffset + 0] = (unsigned char)(height >> 8);  out[heightOffset + 1] = (unsigned char)(height & 0xFF);
+
+        /*! Append the entropy coded data of all strips without their EOI marker, separated by the cycling RST0 to RST7 markers. */
+        for (size_t i=0 ; i < numStrips ; i++) {
+            const std::vector<unsigned char> &strip = strips.strips[i];  if (i > 0) begin = findScanData(strip, NULL);
+            out.insert(out.end(), strip.begin() + begin, strip.end() - 2);
+            if (i + 1 < numStrips) out.push_back(0xFF), out.push_back((unsigned char)(0xD0 + (i & 7)));
+        }
+
+        /*! Terminate the stream with the EOI marker. */
+        out.push_back(0xFF);  out.push_back(0xD9);
+
+    }
+
+#endif // JPEG_LIB_VERSION
+
+    void encodeRGB8_to_JPEG(unsigned char *image, size_t width, size_t height, unsigned char **encoded, size_t *capacity)
+    {
+
+#if JPEG_LIB_VERSION >= 80 || defined(MEM_SRCDST_SUPPORTED)
+
+        /*! Compress strips of the image in parallel. */
+        std::vector<unsigned char> jpeg;  encodeJPEG(image, width, height, 90, jpeg);
+
+        /*! Grow the target buffer if necessary and copy the encoded image. */
+        if (*encoded == NULL || *capacity < jpeg.size()) *encoded = (unsigned char *) realloc(*encoded, jpeg.size());
+        memcpy(*encoded, &jpeg[0], jpeg.size());  *capacity = jpeg.size();
 
 #else  // JPEG_LIB_VERSION
 
@@ -129,16 +221,11 @@ namespace embree
         /*! Decompress the image into an output buffer and get the image dimensions. */
         unsigned char *rgb = decompress(&cinfo);  size_t width = cinfo.output_width;  size_t height = cinfo.output_height;
 
-        /*! Allocate the Embree image. */
-        Ref<Image> image = new Image4c(width, height, filename);
-
-        /*! Convert the image from unsigned char RGB to unsigned char RGBA. */
-        for (size_t y=0, i=0 ; y < height ; y++)
-            for (size_t x=0 ; x < width ; x++)
-                image->set(x, y, Color4((float) rgb[i++] / 255.0f, (float) rgb[i++] / 255.0f, (float) rgb[i++] / 255.0f, 1.0f));
+        /*! The Embree image takes ownership of the packed RGB buffer. */
+        Ref<Image> image = new Image3c(width, height, (Col3c*) rgb, false, filename);
 
         /*! Clean up. */
-        jpeg_destroy_decompress(&cinfo);  free(rgb);  fclose(file);  return(image);
+        jpeg_destroy_decompress(&cinfo);  fclose(file);  return(image);
 
     }
 
@@ -148,6 +235,17 @@ namespace embree
         /*! Open the target JPEG file. */
         FILE *file = fopen(filename.c_str(), "wb");  if (!file) throw std::runtime_error("Unable to open \"" + filename.str() + "\".");
 
+        /*! Convert the image to packed unsigned char RGB in parallel. */
+        std::vector<unsigned char> rgb(3 * image->height * image->width);  if (rgb.size()) convertToRGB8(image, &rgb[0]);
+
+#if JPEG_LIB_VERSION >= 80 || defined(MEM_SRCDST_SUPPORTED)
+
+        /*! Compress strips of the image in parallel and write the joined stream into the target file. */
+        std::vector<unsigned char> jpeg;  encodeJPEG(&rgb[0], image->width, image->height, 75, jpeg);
+        fwrite(&jpeg[0], 1, jpeg.size(), file);  fclose(file);
+
+#else  // JPEG_LIB_VERSION
+
         /*! Compression parameters and scratch space pointers (allocated by the library). */
         struct jpeg_compress_struct cinfo;
 
@@ -166,24 +264,13 @@ namespace embree
         /*! Specify the data source. */
         jpeg_stdio_dest(&cinfo, file);
 
-        /*! Allocate storage for the uncompressed packed image. */
-        unsigned char *rgb = (unsigned char *) malloc(image->height * image->width);
-
-        /*! Convert the image to unsigned char RGB. */
-        for (size_t y=0, i=0 ; y < image->height ; y++) {
-            for (size_t x=0 ; x < image->width ; x++) {
-                const Color4 pixel = image->get(x, y);
-                rgb[i++] = (unsigned char)(clamp(pixel.r) * 255.0f);
-                rgb[i++] = (unsigned char)(clamp(pixel.g) * 255.0f);
-                rgb[i++] = (unsigned char)(clamp(pixel.b) * 255.0f);
-            }
-        }
-
         /*! Compress and write the image into the target file. */
-        compress(&cinfo, rgb);
+        compress(&cinfo, &rgb[0]);
 
         /*! At this point 'jerror.num_warnings' could be checked for corrupt-data warnings. */
-        jpeg_destroy_compress(&cinfo);  free(rgb);  fclose(file);
+        jpeg_destroy_compress(&cinfo);  fclose(file);
+
+#endif // JPEG_LIB_VERSION
 
     }
 
@@ -17,8 +17,11 @@
 #include "image/image.h"
 
 #include <iostream>
+#include <vector>
+#include <algorithm>
 #include <cstring>
 #include <cstdio>
+#include <emmintrin.h>
 
 namespace embree
 {
@@ -37,13 +40,36 @@ namespace embree
     return true;
   }
 
-  /*! read PFM file from disk */
-  Ref<Image> loadPFM(const FileName& fileName)
+  /*! swaps the byte order of 32 bit values in place */
+  static void swapBytes(float* data, size_t num)
   {
-    /* open PPM file */
-    FILE* file = fopen(fileName.c_str(), "rb");
-    if (!file) throw std::runtime_error("cannot open " + fileName.str());
+    size_t i=0;
+    for (; i+4<=num; i+=4) {
+      __m128i v = _mm_loadu_si128((__m128i*)&data[i]);
+      v = _mm_or_si128(_mm_slli_epi16(v,8),_mm_srli_epi16(v,8));
+      v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v,_MM_SHUFFLE(2,3,0,1)),_MM_SHUFFLE(2,3,0,1));
+      _mm_storeu_si128((__m128i*)&data[i],v);
+    }
+    for (; i<num; i++) {
+      unsigned char* b = (unsigned char*) &data[i];
+      std::swap(b[0],b[3]); std::swap(b[1],b[2]);
+    }
+  }
+
+  /*! multiplies floats by a constant in place */
+  static void scale(float* data, size_t num, float s)
+  {
+    size_t i=0;
+    const __m128 vs = _mm_set1_ps(s);
+    for (; i+4<=num; i+=4)
+      _mm_storeu_ps(&data[i],_mm_mul_ps(_mm_loadu_ps(&data[i]),vs));
+    for (; i<num; i++)
+      data[i] *= s;
+  }
 
+  /*! read PFM image from an open file */
+  static Ref<Image> readPFM(FILE* file, const FileName& fileName)
+  {
     /* read file type */
     char type[8];
     if (fscanf(file, "%7s", type) != 1)
@@ -58,38 +84,56 @@ namespace embree
     if (fscanf(file, "%i %i %f", &width, &height, &maxColor) != 3)
       throw std::runtime_error("Error reading " + fileName.str());
 
-    /* Check for big endian PFM file */
-    if (maxColor > 0.0f) {
-      fclose(file);
-      throw std::runtime_error("Big endian PFM files not supported");
-    }
-    float rcpMaxColor = -1.0f/float(maxColor);
+    /* positive scale denotes big endian PFM file */
+    const bool bigEndian = maxColor > 0.0f;
+    const float rcpMaxColor = 1.0f/fabsf(maxColor);
 
     /* get return or space */
     fgetc(file);
 
-    /* create image and fill with data */
-    Ref<Image> img = new Image3f(width,height,fileName);
-
-    /* image in binary format 32 bit */
-    if (!strcmp(type, "PF"))
-    {
-      float rgb[3];
-      for (ssize_t y=0; y<height; y++) {
-        for (ssize_t x=0; x<width; x++) {
-          if (fread(rgb,sizeof(rgb),1,file) != 1)
-            throw std::runtime_error("Error reading " + fileName.str());
-          img->set(x,y,Color4(float(rgb[0])*rcpMaxColor,float(rgb[1])*rcpMaxColor,float(rgb[2])*rcpMaxColor,1.0f));
-        }
-      }
+    /* number of channels */
+    size_t channels = 0;
+    if      (!strcmp(type, "PF")) channels = 3;
+    else if (!strcmp(type, "Pf")) channels = 1;
+    else throw std::runtime_error("Invalid magic value in PFM file");
+
+    /* read all pixels at once, color images directly into the image */
+    Ref<Image3f> img = new Image3f(width,height,fileName);
+    const size_t num = channels*size_t(width)*size_t(height);
+    float* data = channels == 3 ? (float*) img->ptr() : (float*) malloc(num*sizeof(float));
+    if (fread(data,sizeof(float),num,file) != num) {
+      if (channels != 3) free(data);
+      throw std::runtime_error("Error reading " + fileName.str());
     }
 
-    /* invalid magic value */
-    else {
-      fclose(file);
-      throw std::runtime_error("Invalid magic value in PFM file");
+    /* convert to native byte order and scale */
+    if (bigEndian) swapBytes(data,num);
+    if (rcpMaxColor != 1.0f) scale(data,num,rcpMaxColor);
+
+    /* expand grayscale images to RGB */
+    if (channels == 1) {
+      Col3f* rgb = (Col3f*) img->ptr();
+      for (size_t i=0; i<num; i++) rgb[i] = Col3f(data[i],data[i],data[i]);
+      free(data);
     }
+    return img.cast<Image>();
+  }
 
+  /*! read PFM file from disk */
+  Ref<Image> loadPFM(const FileName& fileName)
+  {
+    /* open PFM file */
+    FILE* file = fopen(fileName.c_str(), "rb");
+    if (!file) throw std::runtime_error("cannot open " + fileName.str());
+
+    Ref<Image> img;
+    try {
+      img = readPFM(file,fileName);
+    }
+    catch (...) {
+      fclose(file);
+      throw;
+    }
     fclose(file);
     return img;
   }
@@ -101,13 +145,21 @@ namespace embree
     if (!file) throw std::runtime_error("cannot open file " + fileName.str());
     fprintf(file,"PF\n%i %i\n%f\n", int(img->width), int(img->height), -1.0f);
 
-    float rgb[3];
+    /* write RGB float images directly */
+    if (Ref<Image3f> fimg = img.dynamicCast<Image3f>()) {
+      fwrite(fimg->ptr(),sizeof(Col3f),img->width*img->height,file);
+      fclose(file);
+      return;
+    }
+
+    /* convert and write one scanline at a time */
+    std::vector<Col3f> rgb(img->width,Col3f(zero));
     for (size_t y=0; y<img->height; y++) {
       for (size_t x=0; x<img->width; x++) {
-        Color4 c = img->get(x,y);
-        rgb[0] = c.r; rgb[1] = c.g; rgb[2] = c.b;
-        fwrite(rgb,sizeof(rgb),1,file);
+        const Color4 c = img->get(x,y);
+        rgb[x] = Col3f(c.r,c.g,c.b);
       }
+      fwrite(&rgb[0],sizeof(Col3f),rgb.size(),file);
     }
     fclose(file);
   }
@@ -17,8 +17,10 @@
 #include "image/image.h"
 
 #include <iostream>
+#include <vector>
 #include <cstring>
 #include <cstdio>
+#include <emmintrin.h>
 
 namespace embree
 {
@@ -37,13 +39,9 @@ namespace embree
     return true;
   }
 
-  /*! read PPM file from disk */
-  Ref<Image> loadPPM(const FileName& fileName)
+  /*! read PPM image from an open file */
+  static Ref<Image> readPPM(FILE* file, const FileName& fileName)
   {
-    /* open PPM file */
-    FILE* file = fopen(fileName.c_str(), "rb");
-    if (!file) throw std::runtime_error("cannot open " + fileName.str());
-
     /* read file type */
     char type[8];
     if (fscanf(file, "%7s", type) != 1)
@@ -61,12 +59,10 @@ namespace embree
     /* get return or space */
     fgetc(file);
 
-    /* create image and fill with data */
-    Ref<Image> img = new Image4c(width,height,fileName);
-
     /* image in text format */
     if (!strcmp(type, "P3"))
     {
+      Ref<Image> img = new Image3c(width,height,fileName);
       int r, g, b;
       for (ssize_t y=0; y<height; y++) {
         for (ssize_t x=0; x<width; x++) {
@@ -75,40 +71,75 @@ namespace embree
           img->set(x,y,Color4(float(r)*rcpMaxColor,float(g)*rcpMaxColor,float(b)*rcpMaxColor,1.0f));
         }
       }
+      return img;
     }
 
-    /* image in binary format 8 bit */
+    /* image in binary format 8 bit, read directly into the image */
     else if (!strcmp(type, "P6") && maxColor <= 255)
     {
-      unsigned char rgb[3];
-      for (ssize_t y=0; y<height; y++) {
-        for (ssize_t x=0; x<width; x++) {
-          if (fread(rgb,sizeof(rgb),1,file) != 1)
-            throw std::runtime_error("Error reading " + fileName.str());
-          img->set(x,y,Color4(float(rgb[0])*rcpMaxColor,float(rgb[1])*rcpMaxColor,float(rgb[2])*rcpMaxColor,1.0f));
-        }
+      Ref<Image3c> img = new Image3c(width,height,fileName);
+      unsigned char* rgb = (unsigned char*) img->ptr();
+      const size_t bytes = 3*size_t(width)*size_t(height);
+      if (fread(rgb,1,bytes,file) != bytes)
+        throw std::runtime_error("Error reading " + fileName.str());
+
+      /* rescale if maximal color value is not 255 */
+      if (maxColor != 255) {
+        unsigned char lut[256];
+        for (size_t i=0; i<256; i++) lut[i] = (unsigned char)(clamp(float(i)*rcpMaxColor)*255.0f+0.5f);
+        for (size_t i=0; i<bytes; i++) rgb[i] = lut[rgb[i]];
       }
+      return img.cast<Image>();
     }
 
-    /* image in binary format 16 bit */
+    /* image in binary format 16 bit big endian */
     else if (!strcmp(type, "P6"))
     {
-      unsigned short rgb[3];
-      for (ssize_t y=0; y<height; y++) {
-        for (ssize_t x=0; x<width; x++) {
-          if (fread(rgb,sizeof(rgb),1,file) != 1)
-            throw std::runtime_error("Error reading " + fileName.str());
-          img->set(x,y,Color4(float(rgb[0])*rcpMaxColor,float(rgb[1])*rcpMaxColor,float(rgb[2])*rcpMaxColor,1.0f));
-        }
+      const size_t num = 3*size_t(width)*size_t(height);
+      unsigned short* rgb = (unsigned short*) malloc(num*sizeof(unsigned short));
+      if (fread(rgb,sizeof(unsigned short),num,file) != num) {
+        free(rgb);
+        throw std::runtime_error("Error reading " + fileName.str());
+      }
+
+      Ref<Image3f> img = new Image3f(width,height,fileName);
+      float* data = (float*) img->ptr();
+      const __m128 scale = _mm_set1_ps(rcpMaxColor);
+      size_t i=0;
+      for (; i+8<=num; i+=8) {
+        __m128i v = _mm_loadu_si128((__m128i*)&rgb[i]);
+        v = _mm_or_si128(_mm_slli_epi16(v,8),_mm_srli_epi16(v,8));
+        const __m128i zero = _mm_setzero_si128();
+        _mm_storeu_ps(&data[i+0],_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(v,zero)),scale));
+        _mm_storeu_ps(&data[i+4],_mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(v,zero)),scale));
       }
+      for (; i<num; i++) 
+        data[i] = float((unsigned short)((rgb[i] << 8) | (rgb[i] >> 8)))*rcpMaxColor;
+      free(rgb);
+      return img.cast<Image>();
     }
 
     /* invalid magic value */
     else {
-      fclose(file);
       throw std::runtime_error("Invalid magic value in PPM file");
     }
+  }
 
+  /*! read PPM file from disk */
+  Ref<Image> loadPPM(const FileName& fileName)
+  {
+    /* open PPM file */
+    FILE* file = fopen(fileName.c_str(), "rb");
+    if (!file) throw std::runtime_error("cannot open " + fileName.str());
+
+    Ref<Image> img;
+    try {
+      img = readPPM(file,fileName);
+    }
+    catch (...) {
+      fclose(file);
+      throw;
+    }
     fclose(file);
     return img;
   }
@@ -120,13 +151,18 @@ namespace embree
     if (!file) throw std::runtime_error("cannot open file " + fileName.str());
     fprintf(file,"P6\n%i %i\n255\n", int(img->width), int(img->height));
 
-    for (size_t y=0; y<img->height; y++) {
-      for (size_t x=0; x<img->width; x++) {
-        const Color4 c = img->get(x,y);
-        fputc((unsigned char)(clamp(c.r)*255.0f), file);
-        fputc((unsigned char)(clamp(c.g)*255.0f), file);
-        fputc((unsigned char)(clamp(c.b)*255.0f), file);
-      }
+    /* write RGB8 images directly */
+    if (Ref<Image3c> cimg = img.dynamicCast<Image3c>()) {
+      fwrite(cimg->ptr(),3,img->width*img->height,file);
+      fclose(file);
+      return;
+    }
+
+    /* convert strips of scanlines in parallel and write the image at once */
+    std::vector<unsigned char> rgb(3*img->width*img->height);
+    if (rgb.size()) {
+      convertToRGB8(img,&rgb[0]);
+      fwrite(&rgb[0],1,rgb.size(),file);
     }
     fclose(file);
   }
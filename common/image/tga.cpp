@@ -16,6 +16,8 @@
 
 #include "image/image.h"
 
+#include <vector>
+#include <cstring>
 #include <cstdio>
 
 namespace embree
@@ -41,14 +43,96 @@ namespace embree
     fwrite_uchar(0x18, file);
     fwrite_uchar(0x20, file);
 
-    for (size_t y=0; y<img->height; y++) {
-      for (size_t x=0; x<img->width; x++) {
-        Color c = img->get(x,y);
-        fwrite_uchar((unsigned char)(clamp(c.b)*255.0f), file);
-        fwrite_uchar((unsigned char)(clamp(c.g)*255.0f), file);
-        fwrite_uchar((unsigned char)(clamp(c.r)*255.0f), file);
+    /* convert strips of scanlines in parallel and write the image at once */
+    std::vector<unsigned char> bgr(3*img->width*img->height);
+    if (bgr.size()) {
+      convertToRGB8(img,&bgr[0],true);
+      fwrite(&bgr[0],1,bgr.size(),file);
+    }
+    fclose(file);
+  }
+
+  /*! read TGA file from disk, supports uncompressed and RLE compressed true color images */
+  Ref<Image> loadTga(const FileName& fileName)
+  {
+    FILE* file = fopen(fileName.c_str(), "rb");
+    if (!file) throw std::runtime_error("cannot open " + fileName.str());
+
+    /* read header */
+    unsigned char header[18];
+    if (fread(header,sizeof(header),1,file) != 1) {
+      fclose(file);
+      throw std::runtime_error("Error reading " + fileName.str());
+    }
+    const size_t idLength   = header[0];
+    const size_t colorMap   = header[1];
+    const size_t imageType  = header[2];
+    const size_t width      = header[12] | (header[13] << 8);
+    const size_t height     = header[14] | (header[15] << 8);
+    const size_t bpp        = header[16];
+    const bool   topToBottom = (header[17] & 0x20) != 0;
+    if (colorMap != 0 || (imageType != 2 && imageType != 10) || (bpp != 24 && bpp != 32) || width == 0 || height == 0) {
+      fclose(file);
+      throw std::runtime_error("unsupported TGA format in " + fileName.str());
+    }
+    fseek(file,(long)(sizeof(header)+idLength),SEEK_SET);
+
+    /* read the remaining file at once */
+    const size_t channels = bpp/8;
+    const size_t bytes = width*height*channels;
+    std::vector<unsigned char> pixels(bytes);
+    if (imageType == 2) {
+      if (fread(&pixels[0],1,bytes,file) != bytes) {
+        fclose(file);
+        throw std::runtime_error("Error reading " + fileName.str());
+      }
+    }
+
+    /* decode RLE packets */
+    else {
+      long start = ftell(file); fseek(file,0,SEEK_END); long end = ftell(file); fseek(file,start,SEEK_SET);
+      std::vector<unsigned char> rle(end > start ? end-start : 0);
+      if (rle.empty() || fread(&rle[0],1,rle.size(),file) != rle.size()) {
+        fclose(file);
+        throw std::runtime_error("Error reading " + fileName.str());
+      }
+      size_t i=0, o=0;
+      while (o < bytes && i < rle.size()) {
+        const size_t n = min(size_t((rle[i] & 0x7F) + 1), (bytes-o)/channels);
+        if (rle[i++] & 0x80) {
+          if (i+channels > rle.size()) break;
+          for (size_t k=0; k<n; k++, o+=channels) memcpy(&pixels[o],&rle[i],channels);
+          i += channels;
+        } else {
+          if (i+n*channels > rle.size()) break;
+          memcpy(&pixels[o],&rle[i],n*channels);
+          i += n*channels; o += n*channels;
+        }
+      }
+      if (o != bytes) {
+        fclose(file);
+        throw std::runtime_error("Error decoding " + fileName.str());
       }
     }
     fclose(file);
+
+    /* swizzle BGR(A) to RGB(A) and flip bottom to top images */
+    Ref<Image> img;
+    if (channels == 3) img = new Image3c(width,height,fileName);
+    else               img = new Image4c(width,height,fileName);
+    unsigned char* data = (unsigned char*) (channels == 3 ? img.dynamicCast<Image3c>()->ptr() : img.dynamicCast<Image4c>()->ptr());
+    const size_t stride = width*channels;
+    for (size_t y=0; y<height; y++) 
+    {
+      const unsigned char* src = &pixels[(topToBottom ? y : height-1-y)*stride];
+      unsigned char* dst = &data[y*stride];
+      for (size_t x=0; x<stride; x+=channels) {
+        dst[x+0] = src[x+2];
+        dst[x+1] = src[x+1];
+        dst[x+2] = src[x+0];
+        if (channels == 4) dst[x+3] = src[x+3];
+      }
+    }
+    return img;
   }
 }
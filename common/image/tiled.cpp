@@ -0,0 +1,202 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "tiled.h"
+
+#include <cstring>
+
+namespace embree
+{
+  /*! file header of tiled images, followed by the tiles of all levels */
+  struct TiledHeader {
+    char magic[4];      //!< always "ETX1"
+    int32 width;        //!< width of the finest level
+    int32 height;       //!< height of the finest level
+    int32 tileSize;     //!< width and height of a tile
+    int32 numLevels;    //!< number of levels of the pyramid
+    int32 hdr;          //!< 1 for float texels, 0 for 8 bit texels
+  };
+
+  /*! seeks to 64 bit file offsets */
+  static int seek64(FILE* file, int64 offset) {
+#if defined(__WIN32__)
+    return _fseeki64(file,offset,SEEK_SET);
+#else
+    return fseeko(file,offset,SEEK_SET);
+#endif
+  }
+
+  /*! computes size and tile layout of all levels */
+  static void computeLevels(size_t width, size_t height, size_t tileSize, std::vector<TiledImage::Level>& levels)
+  {
+    size_t firstTile = 0;
+    for (size_t w=width, h=height;; w=max(w/2,size_t(1)), h=max(h/2,size_t(1))) 
+    {
+      TiledImage::Level level;
+      level.width = w; level.height = h;
+      level.tilesX = (w+tileSize-1)/tileSize;
+      level.tilesY = (h+tileSize-1)/tileSize;
+      level.firstTile = firstTile;
+      firstTile += level.tilesX*level.tilesY;
+      levels.push_back(level);
+      if (w == 1 && h == 1) break;
+    }
+  }
+
+  TiledImage::TiledImage (const FileName& fileName)
+    : fileName(fileName), file(NULL)
+  {
+    file = fopen(fileName.c_str(),"rb");
+    if (!file) throw std::runtime_error("cannot open " + fileName.str());
+
+    TiledHeader header;
+    if (fread(&header,sizeof(header),1,file) != 1 || strncmp(header.magic,"ETX1",4) || 
+        header.width <= 0 || header.height <= 0 || header.tileSize <= 0) {
+      fclose(file);
+      throw std::runtime_error(fileName.str() + " is no tiled image");
+    }
+    tileSize = header.tileSize;
+    hdr = header.hdr != 0;
+    dataOffset = sizeof(header);
+    computeLevels(header.width,header.height,tileSize,levels);
+    if (levels.size() != size_t(header.numLevels)) {
+      fclose(file);
+      throw std::runtime_error(fileName.str() + " has invalid number of levels");
+    }
+  }
+
+  TiledImage::~TiledImage () {
+    if (file) fclose(file);
+  }
+
+  void TiledImage::readTile(size_t level, size_t tx, size_t ty, void* dst)
+  {
+    const Level& l = levels[level];
+    const int64 offset = dataOffset + int64(l.firstTile + ty*l.tilesX + tx)*tileBytes();
+    Lock<MutexSys> lock(mutex);
+    if (seek64(file,offset) != 0 || fread(dst,tileBytes(),1,file) != 1)
+      throw std::runtime_error("error reading tile from " + fileName.str());
+  }
+
+  Ref<Image> TiledImage::loadLevel(size_t level)
+  {
+    const Level& l = levels[level];
+    Ref<Image> image;
+    if (hdr) image = new Image4f(l.width,l.height,fileName);
+    else     image = new Image4c(l.width,l.height,fileName);
+
+    std::vector<char> tile(tileBytes());
+    for (size_t ty=0; ty<l.tilesY; ty++) {
+      for (size_t tx=0; tx<l.tilesX; tx++) 
+      {
+        readTile(level,tx,ty,&tile[0]);
+        const size_t w = min(tileSize,l.width-tx*tileSize), h = min(tileSize,l.height-ty*tileSize);
+        for (size_t y=0; y<h; y++) {
+          for (size_t x=0; x<w; x++) {
+            const size_t i = y*tileSize+x;
+            const Color4 c = hdr ? Color4(((Col4f*)&tile[0])[i]) : Color4(((Col4c*)&tile[0])[i]);
+            image->set(tx*tileSize+x,ty*tileSize+y,c);
+          }
+        }
+      }
+    }
+    return image;
+  }
+
+  Ref<Image> loadTiled(const FileName& fileName) {
+    Ref<TiledImage> tiled = new TiledImage(fileName);
+    return tiled->loadLevel(0);
+  }
+
+  /*! converts a texel, rounding 8 bit channels to nearest */
+  static __forceinline void convert(const Col4f& c, Col4f& d) { d = c; }
+  static __forceinline void convert(const Col4f& c, Col4c& d) {
+    d = Col4c((unsigned char)(clamp(c.r)*255.0f+0.5f),(unsigned char)(clamp(c.g)*255.0f+0.5f),
+              (unsigned char)(clamp(c.b)*255.0f+0.5f),(unsigned char)(clamp(c.a)*255.0f+0.5f));
+  }
+
+  /*! writes one level as tiles, texels outside the level replicate the border */
+  template<typename T>
+  static void storeLevel(FILE* file, const std::vector<Col4f>& src, const TiledImage::Level& l, size_t tileSize)
+  {
+    std::vector<T> tile(tileSize*tileSize,T(zero));
+    for (size_t ty=0; ty<l.tilesY; ty++) {
+      for (size_t tx=0; tx<l.tilesX; tx++) 
+      {
+        for (size_t y=0; y<tileSize; y++) {
+          const size_t sy = min(ty*tileSize+y,l.height-1);
+          for (size_t x=0; x<tileSize; x++) {
+            const size_t sx = min(tx*tileSize+x,l.width-1);
+            convert(src[sy*l.width+sx],tile[y*tileSize+x]);
+          }
+        }
+        if (fwrite(&tile[0],tile.size()*sizeof(T),1,file) != 1)
+          throw std::runtime_error("error writing tiled image");
+      }
+    }
+  }
+
+  void storeTiled(const Ref<Image>& image, const FileName& fileName, size_t tileSize)
+  {
+    if (tileSize == 0 || (tileSize & (tileSize-1))) 
+      throw std::runtime_error("tile size has to be a power of two");
+    const bool hdr = !dynamic_cast<Image3c*>(image.ptr) && !dynamic_cast<Image4c*>(image.ptr);
+    std::vector<TiledImage::Level> levels;
+    computeLevels(image->width,image->height,tileSize,levels);
+
+    FILE* file = fopen(fileName.c_str(),"wb");
+    if (!file) throw std::runtime_error("cannot open " + fileName.str());
+
+    TiledHeader header;
+    memcpy(header.magic,"ETX1",4);
+    header.width = int32(image->width);
+    header.height = int32(image->height);
+    header.tileSize = int32(tileSize);
+    header.numLevels = int32(levels.size());
+    header.hdr = hdr;
+
+    try 
+    {
+      if (fwrite(&header,sizeof(header),1,file) != 1)
+        throw std::runtime_error("error writing " + fileName.str());
+
+      /* finest level */
+      size_t width = image->width, height = image->height;
+      std::vector<Col4f> src(width*height,Col4f(zero));
+      for (size_t y=0; y<height; y++)
+        for (size_t x=0; x<width; x++)
+          image->get(x,y).set(src[y*width+x]);
+
+      /* store levels and box filter down to the next one */
+      for (size_t i=0; i<levels.size(); i++)
+      {
+        if (hdr) storeLevel<Col4f>(file,src,levels[i],tileSize);
+        else     storeLevel<Col4c>(file,src,levels[i],tileSize);
+        if (i+1 == levels.size()) break;
+
+        const TiledImage::Level& l = levels[i+1];
+        std::vector<Col4f> dst(l.width*l.height,Col4f(zero));
+        downsample2x2(&src[0],width,height,&dst[0],l.width,l.height);
+        src.swap(dst); width = l.width; height = l.height;
+      }
+    }
+    catch (...) {
+      fclose(file);
+      throw;
+    }
+    fclose(file);
+  }
+}
@@ -0,0 +1,73 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#pragma once
+
+#include "image.h"
+#include "sys/sync/mutex.h"
+
+#include <cstdio>
+
+namespace embree
+{
+  /*! Reader for tiled, mip-mapped image files (.etx). The file stores
+   *  a pyramid of levels from finest to coarsest, each split into
+   *  square tiles of RGBA texels. Tiles are read individually, so only
+   *  the parts of an image that are accessed need to be in memory. */
+  class TiledImage : public RefCount
+  {
+  public:
+
+    /*! Size of one level of the pyramid. */
+    struct Level {
+      size_t width, height;      //!< size of the level in texels
+      size_t tilesX, tilesY;     //!< number of tiles in x and y
+      size_t firstTile;          //!< index of the first tile of the level in the file
+    };
+
+    /*! Opens a tiled image file and reads its header. */
+    TiledImage (const FileName& fileName);
+
+    /*! Closes the file. */
+    ~TiledImage ();
+
+    /*! Reads a tile into dst, which has to hold tileBytes() bytes. Thread safe. */
+    void readTile(size_t level, size_t tx, size_t ty, void* dst);
+
+    /*! Returns the number of bytes of one tile. */
+    size_t tileBytes() const { return tileSize*tileSize*(hdr ? sizeof(Col4f) : sizeof(Col4c)); }
+
+    /*! Reads a complete level into a regular image. */
+    Ref<Image> loadLevel(size_t level);
+
+  public:
+    FileName fileName;          //!< file the tiles are read from
+    size_t tileSize;            //!< width and height of a tile in texels
+    bool hdr;                   //!< true for Col4f texels, false for Col4c texels
+    std::vector<Level> levels;  //!< levels from finest to coarsest
+  private:
+    FILE* file;                 //!< open file handle
+    size_t dataOffset;          //!< offset of the first tile in the file
+    MutexSys mutex;             //!< serializes seek and read
+  };
+
+  /*! Writes an image as tiled, mip-mapped file. Images with 8 bit
+   *  channels are stored with 8 bit texels, others with float texels. */
+  void storeTiled(const Ref<Image>& image, const FileName& fileName, size_t tileSize = 64);
+
+  /*! Loads the finest level of a tiled image file. */
+  Ref<Image> loadTiled(const FileName& fileName);
+}
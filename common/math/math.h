@@ -149,6 +149,56 @@ namespace embree
   __forceinline bool  select(bool s, bool  t , bool f) { return s ? t : f; }
   __forceinline int   select(bool s, int   t,   int f) { return s ? t : f; }
   __forceinline float select(bool s, float t, float f) { return s ? t : f; }
+
+  /*! approximate trigonometric functions templated over float and SIMD
+   *  types, the absolute error is below 1E-5 */
+  template<typename T> __forceinline T fast_acos(const T& x) {
+    const T a = abs(x);
+    T p =       T(-0.0012624911f);
+    p = p*a + T( 0.0066700901f);
+    p = p*a + T(-0.0170881256f);
+    p = p*a + T( 0.0308918810f);
+    p = p*a + T(-0.0501743046f);
+    p = p*a + T( 0.0889789874f);
+    p = p*a + T(-0.2145988016f);
+    p = p*a + T( 1.5707963050f);
+    p = p*sqrt(max(T(1.0f)-a,T(0.0f)));
+    return select(x < T(0.0f), T(3.14159265f)-p, p);
+  }
+
+  template<typename T> __forceinline T fast_atan2(const T& y, const T& x) {
+    const T ax = abs(x), ay = abs(y);
+    const T mx = max(ax,ay), mn = min(ax,ay);
+    const T a = select(mx == T(0.0f), T(0.0f), mn/mx), s = a*a;
+    T p =       T(-0.0117212f);
+    p = p*s + T( 0.0526533f);
+    p = p*s + T(-0.1164329f);
+    p = p*s + T( 0.1935435f);
+    p = p*s + T(-0.3326235f);
+    p = p*s + T( 0.9999773f);
+    p = p*a;
+    p = select(ay > ax, T(1.57079633f)-p, p);
+    p = select(x < T(0.0f), T(3.14159265f)-p, p);
+    return select(y < T(0.0f), -p, p);
+  }
+
+  /*! approximate sine for arguments in [-pi,pi] */
+  template<typename T> __forceinline T fast_sin(const T& x) {
+    T r = select(x > T(1.57079633f), T(3.14159265f)-x, x);
+    r = select(r < T(-1.57079633f), T(-3.14159265f)-r, r);
+    const T s = r*r;
+    T p =       T(-2.5052108e-8f);
+    p = p*s + T( 2.7557319e-6f);
+    p = p*s + T(-1.9841270e-4f);
+    p = p*s + T( 8.3333333e-3f);
+    p = p*s + T(-1.6666667e-1f);
+    return r + r*s*p;
+  }
+
+  /*! approximate cosine for arguments in [-pi,pi] */
+  template<typename T> __forceinline T fast_cos(const T& x) {
+    return fast_sin(T(1.57079633f)-abs(x));
+  }
 }
 
 #endif
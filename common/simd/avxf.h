@@ -241,6 +241,16 @@ namespace embree
   template<size_t i> __forceinline const ssef extract   (const avxf& a            ) { return _mm256_extractf128_ps(a  ,i); }
   template<>         __forceinline const ssef extract<0>(const avxf& a            ) { return _mm256_castps256_ps128(a); }
 
+  ////////////////////////////////////////////////////////////////////////////////
+  /// Exponential Functions
+  ////////////////////////////////////////////////////////////////////////////////
+
+  /*! AVX has no 256 bit integer operations, thus both halves are
+   *  processed with the SSE approximations. */
+  __forceinline const avxf exp2( const avxf& a ) { return avxf(exp2(extract<0>(a)),exp2(extract<1>(a))); }
+  __forceinline const avxf log2( const avxf& a ) { return avxf(log2(extract<0>(a)),log2(extract<1>(a))); }
+  __forceinline const avxf pow ( const avxf& a, const avxf& b ) { return exp2(b*log2(a)); }
+
   ////////////////////////////////////////////////////////////////////////////////
   /// Transpose
   ////////////////////////////////////////////////////////////////////////////////
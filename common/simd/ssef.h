@@ -197,6 +197,36 @@ namespace embree
   __forceinline const ssef floor     ( const ssef& a ) { return _mm_round_ps(a, _MM_FROUND_TO_NEG_INF    ); }
   __forceinline const ssef ceil      ( const ssef& a ) { return _mm_round_ps(a, _MM_FROUND_TO_POS_INF    ); }
 
+  ////////////////////////////////////////////////////////////////////////////////
+  /// Exponential Functions
+  ////////////////////////////////////////////////////////////////////////////////
+
+  /*! Approximates 2^a with a relative error below 2E-7 using a
+   *  polynomial for the fractional part. */
+  __forceinline const ssef exp2( const ssef& a0 )
+  {
+    const ssef a = min(max(a0,ssef(-126.99999f)),ssef(129.0f));
+    const __m128i i = _mm_cvtps_epi32(_mm_sub_ps(a,ssef(0.5f)));
+    const ssef f = a - ssef(_mm_cvtepi32_ps(i));
+    const ssef e = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(i,_mm_set1_epi32(127)),23));
+    const ssef p = madd(madd(madd(madd(madd(ssef(1.8775767E-3f),f,ssef(8.9893397E-3f)),f,ssef(5.5826318E-2f)),f,ssef(2.4015361E-1f)),f,ssef(6.9315308E-1f)),f,ssef(9.9999994E-1f));
+    return e*p;
+  }
+
+  /*! Approximates log2(a) for positive a with an absolute error below
+   *  1E-5 using a polynomial for the mantissa. */
+  __forceinline const ssef log2( const ssef& a )
+  {
+    const __m128i i = _mm_castps_si128(a);
+    const ssef e = ssef(_mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(i,23),_mm_set1_epi32(127))));
+    const ssef m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(i,_mm_set1_epi32(0x007FFFFF)),_mm_set1_epi32(0x3F800000)));
+    const ssef p = madd(madd(madd(madd(ssef(5.96515482674574969533E-2f),m,ssef(-4.65725644288844778798E-1f)),m,ssef(1.48116647521213171641f)),m,ssef(-2.52074962577807006663f)),m,ssef(2.8882704548164776201f));
+    return madd(p,m-ssef(one),e);
+  }
+
+  /*! Approximates a^b for positive a. */
+  __forceinline const ssef pow( const ssef& a, const ssef& b ) { return exp2(b*log2(a)); }
+
   ////////////////////////////////////////////////////////////////////////////////
   /// Movement/Shifting/Shuffling Functions
   ////////////////////////////////////////////////////////////////////////////////
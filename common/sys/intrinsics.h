@@ -20,7 +20,7 @@
 #include "platform.h"
 #include <xmmintrin.h>
 
-#if defined __MIC__
+#if defined __MIC__ || defined __AVX__
 #include <immintrin.h>
 #endif
 
@@ -144,6 +144,8 @@ __forceinline void __cpuid(int out[4], int op) {
   asm volatile ("cpuid" : "=a"(out[0]), "=b"(out[1]), "=c"(out[2]), "=d"(out[3]) : "a"(op)); 
 }
 
+/* newer GCC versions already define these in immintrin.h */
+#if !defined(_X86GPRINTRIN_H_INCLUDED)
 __forceinline uint64 __rdtsc()  {
   uint32 high,low;
   asm volatile ("rdtsc" : "=d"(high), "=a"(low));
@@ -155,6 +157,7 @@ __forceinline uint64 __rdpmc(int i) {
   asm volatile ("rdpmc" : "=d"(high), "=a"(low) : "c"(i));
   return (((uint64)high) << 32) + (uint64)low;
 }
+#endif
 
 __forceinline unsigned int __popcnt(unsigned int in) {
   int r = 0; asm ("popcnt %1,%0" : "=r"(r) : "r"(in)); return r;
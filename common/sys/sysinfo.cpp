@@ -87,6 +87,35 @@ namespace embree
     if (model == 0x2A) return CPU_CORE_SANDYBRIDGE;  // Core i7, SandyBridge
     return CPU_UNKNOWN;
   }
+
+  /*! checks the given feature bits of cpuid leaf 1 and whether the OS saves the YMM state */
+  static bool hasVEXFeatures(int features)
+  {
+    int out[4];
+    __cpuid(out, 0);
+    if (out[0] < 1) return false;
+    __cpuid(out, 1);
+    const int osxsave = 1 << 27;
+    if ((out[2] & (osxsave|features)) != (osxsave|features)) return false;
+
+    /* VEX encoded instructions require the OS to save the YMM state */
+#if defined(__WIN32__)
+    const uint64 xcr0 = _xgetbv(0);
+#else
+    uint32 low, high;
+    asm volatile ("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+    const uint64 xcr0 = (((uint64)high) << 32) + (uint64)low;
+#endif
+    return (xcr0 & 6) == 6;
+  }
+
+  bool hasAVX() {
+    return hasVEXFeatures(1 << 28);
+  }
+
+  bool hasF16C() {
+    return hasVEXFeatures((1 << 28) | (1 << 29));
+  }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
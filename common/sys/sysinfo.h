@@ -41,6 +41,12 @@ namespace embree
   /*! get microprocessor model */
   CPUModel getCPUModel(); 
 
+  /*! returns true if the CPU and the OS support the AVX instructions */
+  bool hasAVX();
+
+  /*! returns true if the CPU and the OS support the F16C half precision conversion instructions */
+  bool hasF16C();
+
   /*! return the number of logical threads of the system */
   size_t getNumberOfLogicalThreads();
   
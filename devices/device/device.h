@@ -309,6 +309,24 @@ namespace embree
      *  frameBuffer is the framebuffer to render into */
     virtual void rtRenderFrame(RTRenderer renderer, RTCamera camera, RTScene scene, RTToneMapper tonemapper, RTFrameBuffer frameBuffer, int accumulate) = 0;
 
+    /*! Renders a frame asynchronously, the call returns immediately.
+     *  Same parameters as rtRenderFrame. \param cancel points to a
+     *  token that aborts the frame when set to a nonzero value, it is
+     *  checked before every tile and has to stay valid until the frame
+     *  finished. Tiles not rendered keep their previous content. Use
+     *  rtFrameReady or rtWaitFrame to wait for the frame; mapping the
+     *  framebuffer waits too. Devices without asynchronous rendering
+     *  render synchronously. */
+    virtual void rtRenderFrameAsync(RTRenderer renderer, RTCamera camera, RTScene scene, RTToneMapper tonemapper, RTFrameBuffer frameBuffer, int accumulate, volatile int* cancel = NULL) {
+      rtRenderFrame(renderer,camera,scene,tonemapper,frameBuffer,accumulate);
+    }
+
+    /*! Returns true if no frame renders into the framebuffer anymore. */
+    virtual bool rtFrameReady(RTFrameBuffer frameBuffer) { return true; }
+
+    /*! Waits until no frame renders into the framebuffer anymore. */
+    virtual void rtWaitFrame(RTFrameBuffer frameBuffer) {}
+
     /*! Pick a 3D point. \returns true if a point was picked, false otherwise
      *  \parm x is the x coordinate [0:1] in the image plane
      *  \parm y is the y coordinate [0:1] in the image plane
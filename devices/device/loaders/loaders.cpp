@@ -16,6 +16,7 @@
 
 #include "loaders.h"
 #include "sys/stl/string.h"
+#include "image/image.h"
 #include <map>
 
 namespace embree
@@ -26,6 +27,18 @@ namespace embree
 
   static std::map<std::string, Handle<Device::RTImage> >* image_map = NULL;
 
+  void rtPrefetchImage(const FileName &fileName)
+  {
+    /*! images prefixed with server: get loaded by the device */
+    if (!strncmp(fileName.c_str(),"server:",7)) return;
+
+    /*! tiled images get paged in by the device */
+    if (std::strlwr(fileName.ext()) == "etx") return;
+
+    /*! the device picks the image up from the image cache */
+    loadImageAsync(fileName,true);
+  }
+
   Handle<Device::RTImage> rtLoadImage(const FileName &fileName) 
   {
     if (image_map == NULL) 
@@ -33,13 +46,14 @@ namespace embree
     
     if (image_map->find(fileName.str()) != image_map->end()) 
       return((*image_map)[fileName.str()]);
-    
+
     return((*image_map)[fileName.str()] = g_device->rtNewImageFromFile(fileName.c_str()));
   }
 
   void rtClearImageCache() {
     if (image_map) delete image_map; 
     image_map = NULL;
+    clearImageCache();
   }
 
   static std::map<std::string, Handle<Device::RTTexture> >* texture_map = NULL;
@@ -52,8 +66,20 @@ namespace embree
     if (texture_map->find(fileName.str()) != texture_map->end()) 
       return((*texture_map)[fileName.str()]);
     
-    Handle<Device::RTTexture> texture = g_device->rtNewTexture("nearest");
-    g_device->rtSetImage(texture, "image", rtLoadImage(fileName));
+    /* tiled images are read on demand by devices that support paged textures */
+    Handle<Device::RTTexture> texture;
+    if (std::strlwr(fileName.ext()) == "etx") {
+      try {
+        texture = g_device->rtNewTexture("paged");
+        g_device->rtSetString(texture, "file", fileName.c_str());
+      } catch (const std::runtime_error&) {
+        texture = null;
+      }
+    }
+    if (!texture) {
+      texture = g_device->rtNewTexture("image");
+      g_device->rtSetImage(texture, "image", rtLoadImage(fileName));
+    }
     g_device->rtCommit(texture);
     
     return((*texture_map)[fileName.str()] = texture);
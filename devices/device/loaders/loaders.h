@@ -26,6 +26,7 @@ namespace embree
   extern std::string g_mesh_builder;
   extern std::string g_mesh_traverser;
 
+  void rtPrefetchImage(const FileName& fileName);
   Handle<Device::RTImage> rtLoadImage  (const FileName& fileName);
   void rtClearImageCache();
 
@@ -51,6 +51,7 @@ namespace embree
     std::vector<Handle<Device::RTPrimitive> > loadScene(const Ref<XML>& xml);
     std::vector<Handle<Device::RTPrimitive> > loadTransformNode(const Ref<XML>& xml);
     std::vector<Handle<Device::RTPrimitive> > loadGroupNode(const Ref<XML>& xml);
+    void prefetchImages(const Ref<XML>& xml);
 
   private:
     template<typename T> T load(const Ref<XML>& xml) { return T(zero); }
@@ -589,6 +590,21 @@ namespace embree
     return prims;
   }
 
+  //////////////////////////////////////////////////////////////////////////////
+  //// Decoding of images in the background while the geometry gets loaded
+  //////////////////////////////////////////////////////////////////////////////
+
+  void XMLLoader::prefetchImages(const Ref<XML>& xml)
+  {
+    if (xml->name == "texture" && xml->body.size() == 1) 
+      rtPrefetchImage(path + xml->body[0].String());
+    else if (xml->name == "HDRILight" && xml->childOpt("image")) 
+      rtPrefetchImage(path + load<std::string>(xml->child("image")));
+    else 
+      for (size_t i=0; i<xml->children.size(); i++) 
+        prefetchImages(xml->children[i]);
+  }
+
   XMLLoader::XMLLoader(const FileName& fileName) : binFile(NULL)
   {
     path = fileName.path();
@@ -599,6 +615,7 @@ namespace embree
 
     Ref<XML> xml = parseXML(fileName);
     if (xml->name != "scene") throw std::runtime_error(xml->loc.str()+": invalid scene tag");
+    prefetchImages(xml);
     for (size_t i=0; i<xml->children.size(); i++) {
       std::vector<Handle<Device::RTPrimitive> > prims = loadScene(xml->children[i]);
       model.insert(model.end(), prims.begin(), prims.end());
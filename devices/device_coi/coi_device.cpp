@@ -446,6 +446,7 @@ namespace embree
     if      (!strcasecmp(type,"RGB_FLOAT32")) swapchain = new SwapChain(&process,width*height*3*sizeof(float),numBuffers);
     else if (!strcasecmp(type,"RGBA8"      )) swapchain = new SwapChain(&process,width*height*4,numBuffers);
     else if (!strcasecmp(type,"RGB8"       )) swapchain = new SwapChain(&process,width*height*3,numBuffers);
+    else if (!strcasecmp(type,"RGBA_HALF16")) swapchain = new SwapChain(&process,width*height*4*sizeof(unsigned short),numBuffers);
     else throw std::runtime_error("unknown framebuffer type: "+std::string(type));
     swapchains[(int)(long)id] = swapchain;
 
@@ -1056,6 +1057,7 @@ namespace embree
     if      (!strcasecmp(type,"RGB_FLOAT32")) buffers[id] = new SwapChain(type,width,height,numBuffers,ptrs,FrameBufferRGBFloat32::create);
     else if (!strcasecmp(type,"RGBA8"      )) buffers[id] = new SwapChain(type,width,height,numBuffers,ptrs,FrameBufferRGBA8     ::create);
     else if (!strcasecmp(type,"RGB8"       )) buffers[id] = new SwapChain(type,width,height,numBuffers,ptrs,FrameBufferRGB8      ::create);
+    else if (!strcasecmp(type,"RGBA_HALF16")) buffers[id] = new SwapChain(type,width,height,numBuffers,ptrs,FrameBufferRGBAHalf16::create);
     else throw std::runtime_error("unknown framebuffer type: "+std::string(type));
 
     return hid;
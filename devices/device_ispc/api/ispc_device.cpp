@@ -176,7 +176,8 @@ namespace embree
       throw std::runtime_error("rtNewImageFromFile not supported on MIC");
 #else
     if (!strncmp(file,"server:",7)) file += 7;
-    Ref<Image> image = loadImage(file);
+    Ref<Image> image = loadImage(file,true);
+    evictImage(file); // the device keeps its own reference or copy
     if (Ref<Image4f> img = image.dynamicCast<Image4f>())
       return rtNewImage("RGBA_FLOAT32",img->width,img->height,img->ptr(),true);
     else if (Ref<Image3f> img = image.dynamicCast<Image3f>())
@@ -676,6 +677,13 @@ namespace embree
     Lock<MutexSys> lock(mutex);
     if (!handle  ) throw std::runtime_error("invalid handle"  );
     if (!property) throw std::runtime_error("invalid property");
+
+    /* frame budgets are only implemented by the singleray device */
+    if (!strcmp(property,"frameBudget") && x > 0.0f) {
+      static bool warned = false;
+      if (!warned) printf("WARNING: frameBudget not supported by the ISPC device, rendering at full resolution\n");
+      warned = true;
+    }
     ((_RTHandle*)handle)->set(property,Variant(x));
   }
 
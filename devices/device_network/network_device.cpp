@@ -261,6 +261,7 @@ namespace embree
         if      (format == "RGB_FLOAT32") rowBytes = 3*width*sizeof(float);
         else if (format == "RGBA8"      ) rowBytes = 4*width*sizeof(char);
         else if (format == "RGB8"       ) rowBytes = (3*width*sizeof(char)+3)/4*4;
+        else if (format == "RGBA_HALF16") rowBytes = 4*width*sizeof(unsigned short);
         else throw std::runtime_error("unknown framebuffer format");
 
         /*! store data directly into framebuffer */
@@ -427,7 +428,8 @@ namespace embree
 #if defined(__MIC__)      
       throw std::runtime_error("rtNewImageFromFile not supported on MIC");
 #else
-      Ref<Image> image = loadImage(fileName);
+      Ref<Image> image = loadImage(fileName,true);
+      evictImage(fileName); // the device keeps its own reference or copy
       if (!image) throw std::runtime_error("cannot load image: "+std::string(fileName));
       else if (Ref<Image3c> cimg = image.dynamicCast<Image3c>())
         return rtNewImage("RGB8",cimg->width,cimg->height,cimg->ptr(),true);
@@ -627,6 +629,7 @@ namespace embree
     if      (!strcasecmp(type,"RGB_FLOAT32")) buffers[id] = new SwapChain(type,width,height,numBuffers,ptrs,FrameBufferRGBFloat32::create);
     else if (!strcasecmp(type,"RGBA8"      )) buffers[id] = new SwapChain(type,width,height,numBuffers,ptrs,FrameBufferRGBA8     ::create);
     else if (!strcasecmp(type,"RGB8"       )) buffers[id] = new SwapChain(type,width,height,numBuffers,ptrs,FrameBufferRGB8      ::create);
+    else if (!strcasecmp(type,"RGBA_HALF16")) buffers[id] = new SwapChain(type,width,height,numBuffers,ptrs,FrameBufferRGBAHalf16::create);
     else throw std::runtime_error("unknown framebuffer type: "+std::string(type));
 
     return (Device::RTFrameBuffer)(long)id;
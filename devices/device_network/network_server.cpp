@@ -715,6 +715,7 @@ namespace embree
       if      (type == "RGB_FLOAT32") bytes = 3 * width * height1 * sizeof(float);
       else if (type == "RGBA8"      ) bytes = 4 * width * height1;
       else if (type == "RGB8"       ) bytes = ((3 * width + 3) / 4 * 4) * height1;
+      else if (type == "RGBA_HALF16") bytes = 4 * width * height1 * sizeof(unsigned short);
       else throw std::runtime_error("unsupported framebuffer format: " + type);
       network::write(server->socket, data, bytes);
       break;
@@ -18,14 +18,32 @@
 #define __EMBREE_FRAMEBUFFER_H__
 
 #include "../default.h"
+#include "image/compressed.h"
+#include "sys/sysinfo.h"
 
 namespace embree
 {
+  /*! compiled with AVX in framebuffer_avx.cpp, process multiples of 8 pixels and return how many pixels were done */
+  size_t updateRun_AVX(float* pixel, float* r, float* g, float* b, size_t n, const float weight, bool accu);
+  size_t packRGBA8_AVX(unsigned char* pixel, const float* r, const float* g, const float* b, size_t n);
+
   /*! Normalizes a color. */
   __forceinline Vec4f normalizeColor(const Vec4f& c) { 
     return c * rcp(c.w); 
   }
   
+  /*! Converts 4 colors to 8 bit per channel with the same clamping
+   *  and truncation as the scalar framebuffers. Each 32 bit lane
+   *  holds the bytes red, green, blue, and zero. */
+  __forceinline __m128i packRGB(const ssef& r, const ssef& g, const ssef& b) 
+  {
+    const ssef lower(zero), upper(255.0f);
+    const __m128i ir = _mm_cvttps_epi32(clamp(r*upper,lower,upper));
+    const __m128i ig = _mm_cvttps_epi32(clamp(g*upper,lower,upper));
+    const __m128i ib = _mm_cvttps_epi32(clamp(b*upper,lower,upper));
+    return _mm_or_si128(ir,_mm_or_si128(_mm_slli_epi32(ig,8),_mm_slli_epi32(ib,16)));
+  }
+
   /*! framebuffers the swapchain consists of */
   struct FrameBuffer : public RefCount
   {
@@ -38,6 +56,11 @@ namespace embree
 
     /*! write pixel */
     virtual void set(size_t x, size_t y, const Color& c) = 0;
+
+    /*! write n consecutive pixels of a row starting at (x,y) from arrays of red, green, and blue values */
+    virtual void setRow(size_t x, size_t y, const float* r, const float* g, const float* b, size_t n) {
+      for (size_t i=0; i<n; i++) set(x+i,y,Color(r[i],g[i],b[i]));
+    }
     
     /*! return the width of the framebuffer */
     __forceinline size_t getWidth() const { return width;  }
@@ -74,6 +97,12 @@ namespace embree
       Lock<MutexSys> lock(mutex);
       while (remainingTiles != 0) condition.wait(mutex);
     }
+
+    /*! returns true if rendering finished */
+    bool ready() {
+      Lock<MutexSys> lock(mutex);
+      return remainingTiles == 0;
+    }
     
   protected:
     size_t width;              //!< width of the framebuffer in pixels
@@ -126,6 +155,21 @@ namespace embree
     void set(size_t x, size_t y, const Color& c) {
       ((Col3f*)data)[y*width+x] = Col3f(c.r,c.g,c.b);
     }
+
+    /*! write pixels, overlapping 4 wide stores write one pixel each */
+    void setRow(size_t x, size_t y, const float* r, const float* g, const float* b, size_t n) 
+    {
+      float* pixel = (float*)((Col3f*)data+y*width+x);
+      size_t i=0;
+      for (; i+4<=n; i+=4) {
+        ssef c0,c1,c2,c3; transpose(_mm_loadu_ps(r+i),_mm_loadu_ps(g+i),_mm_loadu_ps(b+i),ssef(zero),c0,c1,c2,c3);
+        _mm_storeu_ps(pixel+3*i+0,c0);
+        _mm_storeu_ps(pixel+3*i+3,c1);
+        _mm_storeu_ps(pixel+3*i+6,c2);
+        set(x+i+3,y,Color(c3[0],c3[1],c3[2]));
+      }
+      for (; i<n; i++) set(x+i,y,Color(r[i],g[i],b[i]));
+    }
   };
 
   /*! RGBA8 framebuffer */
@@ -175,6 +219,19 @@ namespace embree
       pixel[2] = (unsigned char) clamp(c.b*255.0f,0.0f,255.0f);
       pixel[3] = 0;
     }
+
+    /*! write pixels, 8 at a time with AVX and 4 at a time otherwise */
+    void setRow(size_t x, size_t y, const float* r, const float* g, const float* b, size_t n) 
+    {
+      static const bool avx = hasAVX();
+      unsigned char* pixel = (unsigned char*)data+stride*y+4*x;
+      size_t i = avx ? packRGBA8_AVX(pixel,r,g,b,n) : 0;
+      for (; i+4<=n; i+=4) {
+        const __m128i c = packRGB(_mm_loadu_ps(r+i),_mm_loadu_ps(g+i),_mm_loadu_ps(b+i));
+        _mm_storeu_si128((__m128i*)(pixel+4*i),c);
+      }
+      for (; i<n; i++) set(x+i,y,Color(r[i],g[i],b[i]));
+    }
   };
 
   /*! RGB8 framebuffer */
@@ -223,9 +280,81 @@ namespace embree
       pixel[1] = (unsigned char) clamp(c.g*255.0f,0.0f,255.0f);
       pixel[2] = (unsigned char) clamp(c.b*255.0f,0.0f,255.0f);
     }
+
+    /*! write pixels, 4 at a time */
+    void setRow(size_t x, size_t y, const float* r, const float* g, const float* b, size_t n) 
+    {
+      unsigned char* pixel = (unsigned char*)data+stride*y+3*x;
+      const __m128i lo = _mm_set_epi32(0,0x00FFFFFF,0,0x00FFFFFF);
+      const __m128i hi = _mm_set_epi32(0x0000FFFF,int(0xFF000000),0x0000FFFF,int(0xFF000000));
+      size_t i=0;
+      for (; i+4<=n; i+=4) {
+        /*! drop the zero byte of each pixel within the 64 bit halves, then close the gap between the halves */
+        const __m128i p = packRGB(_mm_loadu_ps(r+i),_mm_loadu_ps(g+i),_mm_loadu_ps(b+i));
+        const __m128i h = _mm_or_si128(_mm_and_si128(p,lo),_mm_and_si128(_mm_srli_epi64(p,8),hi));
+        const __m128i c = _mm_or_si128(_mm_move_epi64(h),_mm_slli_si128(_mm_srli_si128(h,8),6));
+        _mm_storel_epi64((__m128i*)(pixel+3*i),c);
+        *(int*)(pixel+3*i+8) = _mm_cvtsi128_si32(_mm_srli_si128(c,8));
+      }
+      for (; i<n; i++) set(x+i,y,Color(r[i],g[i],b[i]));
+    }
   };
 
-  /*! accumulation buffer */
+  /*! RGBA_HALF16 framebuffer, stores half precision RGBA pixels with alpha set to one */
+  struct FrameBufferRGBAHalf16 : public FrameBuffer
+  {
+  public:
+
+    /*! class factory */
+    static FrameBuffer* create(size_t width, size_t height, void* ptr) {
+      return new FrameBufferRGBAHalf16(width,height,ptr);
+    }
+
+  protected:
+
+    /*! constructs a new framebuffer of specified size */
+    FrameBufferRGBAHalf16 (size_t width, size_t height, void* ptr)
+      : FrameBuffer(width,height,4*width*sizeof(unsigned short),ptr) 
+    {
+      if (!data) {
+        data = (void*) new unsigned short[4*width*height];
+        allocated = true;
+      }
+      memset(data,0,stride*height);
+    }
+    
+    /*! destroys the framebuffer */
+    ~FrameBufferRGBAHalf16 () {
+      if (allocated) delete[] (unsigned short*) data; data = NULL;
+    }
+
+    /*! read pixel */
+    const Color get(size_t x, size_t y) const 
+    {
+      const unsigned short* pixel = (unsigned short*)data+4*(y*width+x);
+      return Color(half2float(pixel[0]),half2float(pixel[1]),half2float(pixel[2]));
+    }
+
+    /*! write pixel */
+    void set(size_t x, size_t y, const Color& c)
+    {
+      unsigned short* pixel = (unsigned short*)data+4*(y*width+x);
+      pixel[0] = float2half(c.r);
+      pixel[1] = float2half(c.g);
+      pixel[2] = float2half(c.b);
+      pixel[3] = 0x3C00;
+    }
+
+    /*! write pixels */
+    void setRow(size_t x, size_t y, const float* r, const float* g, const float* b, size_t n) {
+      float2halfRGBA((unsigned short*)data+4*(y*width+x),r,g,b,n);
+    }
+  };
+
+  /*! accumulation buffer, stored row major. A 16x16 tile blocked
+   *  layout was measured to be slower, because each tile row is
+   *  already a contiguous run and sixteen row streams prefetch better
+   *  than a single blocked stream. */
   struct AccuBuffer : public RefCount
   {
   public:
@@ -268,33 +397,82 @@ namespace embree
     }
 
     /*! update pixel */
-    __forceinline Color update(size_t x, size_t y, const Color& c, const float weight, bool accu) 
+    __forceinline Color update(size_t x, size_t y, const Color& c, const float weight, bool accu) {
+      return update(data[y*width+x],c,weight,accu);
+    }
+
+    /*! update n consecutive pixels of a row starting at (x,y) with
+     *  the colors given as arrays of red, green, and blue values. The
+     *  normalized colors are returned in the same arrays. */
+    __forceinline void update(size_t x, size_t y, float* r, float* g, float* b, size_t n, const float weight, bool accu)
+    {
+      updateRun(&data[y*width+x],r,g,b,n,weight,accu);
+    }
+
+    /*! read accumulated radiance and weight of a pixel */
+    __forceinline const Vec4f& getSum(size_t x, size_t y) const {
+      return data[y*width+x];
+    }
+
+    /*! read pixel */
+    __forceinline const Color get(size_t x, size_t y) const 
+    {
+      const Vec4f& c = data[y*width+x];
+      const float norm = rcp(c.w);
+      return Color(c.x,c.y,c.z)*norm;
+    }
+
+  private:
+
+    /*! update a single pixel */
+    static __forceinline Color update(Vec4f& pixel, const Color& c, const float weight, bool accu) 
     {
       if (accu) {
-        const Vec4f cur = data[y*width+x];
-        const Vec4f next = cur + Vec4f(c.r,c.g,c.b,weight);
-        data[y*width+x] = next;
+        const Vec4f next = pixel + Vec4f(c.r,c.g,c.b,weight);
+        pixel = next;
         const float norm = rcp(next.w);
         return Color(next.x,next.y,next.z)*norm;
       }
       else {
-        data[y*width+x] = Vec4f(c.r,c.g,c.b,weight);
+        pixel = Vec4f(c.r,c.g,c.b,weight);
         return c*rcp(weight);
       }
     }
 
-    /*! read pixel */
-    __forceinline const Color get(size_t x, size_t y) const 
+    /*! update pixels that are consecutive in memory */
+    static __forceinline void updateRun(Vec4f* data, float* r, float* g, float* b, size_t n, const float weight, bool accu)
     {
-      const Vec4f& c = data[y*width+x];
-      const float norm = rcp(c.w);
-      return Color(c.x,c.y,c.z)*norm;
+      static const bool avx = hasAVX();
+      float* pixel = (float*)data;
+      size_t i = avx ? updateRun_AVX(pixel,r,g,b,n,weight,accu) : 0;
+      for (; i+4<=n; i+=4) 
+      {
+        ssef R,G,B,W; 
+        transpose(_mm_loadu_ps(pixel+4*i+0),_mm_loadu_ps(pixel+4*i+4),_mm_loadu_ps(pixel+4*i+8),_mm_loadu_ps(pixel+4*i+12),R,G,B,W);
+        if (accu) { R += _mm_loadu_ps(r+i); G += _mm_loadu_ps(g+i); B += _mm_loadu_ps(b+i); W += ssef(weight); }
+        else      { R  = _mm_loadu_ps(r+i); G  = _mm_loadu_ps(g+i); B  = _mm_loadu_ps(b+i); W  = ssef(weight); }
+
+        ssef c0,c1,c2,c3; transpose(R,G,B,W,c0,c1,c2,c3);
+        _mm_storeu_ps(pixel+4*i+0,c0);
+        _mm_storeu_ps(pixel+4*i+4,c1);
+        _mm_storeu_ps(pixel+4*i+8,c2);
+        _mm_storeu_ps(pixel+4*i+12,c3);
+
+        const ssef norm = rcp(W);
+        _mm_storeu_ps(r+i,R*norm);
+        _mm_storeu_ps(g+i,G*norm);
+        _mm_storeu_ps(b+i,B*norm);
+      }
+      for (; i<n; i++) {
+        const Color c = update(data[i],Color(r[i],g[i],b[i]),weight,accu);
+        r[i] = c.r; g[i] = c.g; b[i] = c.b;
+      }
     }
 
   protected:
     size_t width;              //!< width of the framebuffer in pixels
     size_t height;             //!< height of the framebuffer in pixels
-    Vec4f* data;                //!< framebuffer data
+    Vec4f* data;               //!< framebuffer data
   };
 }
 
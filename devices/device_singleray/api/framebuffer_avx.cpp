@@ -0,0 +1,71 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "math/math.h"
+#include "simd/avx.h"
+
+/*! This file is compiled with AVX enabled and only called after
+ *  checking for AVX support at runtime, thus it must only include
+ *  headers whose functions are all force inlined. */
+
+namespace embree
+{
+  size_t updateRun_AVX(float* pixel, float* r, float* g, float* b, size_t n, const float weight, bool accu)
+  {
+    size_t i=0;
+    for (; i+8<=n; i+=8)
+    {
+      /*! each 128 bit lane transposes 4 pixels, the lower one pixels i to i+3, the upper one pixels i+4 to i+7 */
+      const avxf p0(ssef(_mm_loadu_ps(pixel+4*i+ 0)),ssef(_mm_loadu_ps(pixel+4*i+16)));
+      const avxf p1(ssef(_mm_loadu_ps(pixel+4*i+ 4)),ssef(_mm_loadu_ps(pixel+4*i+20)));
+      const avxf p2(ssef(_mm_loadu_ps(pixel+4*i+ 8)),ssef(_mm_loadu_ps(pixel+4*i+24)));
+      const avxf p3(ssef(_mm_loadu_ps(pixel+4*i+12)),ssef(_mm_loadu_ps(pixel+4*i+28)));
+      avxf R,G,B,W; transpose4(p0,p1,p2,p3,R,G,B,W);
+      if (accu) { R += avxf(_mm256_loadu_ps(r+i)); G += avxf(_mm256_loadu_ps(g+i)); B += avxf(_mm256_loadu_ps(b+i)); W += avxf(weight); }
+      else      { R  = avxf(_mm256_loadu_ps(r+i)); G  = avxf(_mm256_loadu_ps(g+i)); B  = avxf(_mm256_loadu_ps(b+i)); W  = avxf(weight); }
+
+      avxf c0,c1,c2,c3; transpose4(R,G,B,W,c0,c1,c2,c3);
+      _mm_storeu_ps(pixel+4*i+ 0,extract<0>(c0)); _mm_storeu_ps(pixel+4*i+16,extract<1>(c0));
+      _mm_storeu_ps(pixel+4*i+ 4,extract<0>(c1)); _mm_storeu_ps(pixel+4*i+20,extract<1>(c1));
+      _mm_storeu_ps(pixel+4*i+ 8,extract<0>(c2)); _mm_storeu_ps(pixel+4*i+24,extract<1>(c2));
+      _mm_storeu_ps(pixel+4*i+12,extract<0>(c3)); _mm_storeu_ps(pixel+4*i+28,extract<1>(c3));
+
+      const avxf norm = rcp(W);
+      _mm256_storeu_ps(r+i,R*norm);
+      _mm256_storeu_ps(g+i,G*norm);
+      _mm256_storeu_ps(b+i,B*norm);
+    }
+    return i;
+  }
+
+  size_t packRGBA8_AVX(unsigned char* pixel, const float* r, const float* g, const float* b, size_t n)
+  {
+    const avxf lower(zero), upper(255.0f);
+    size_t i=0;
+    for (; i+8<=n; i+=8)
+    {
+      /*! AVX has no 256 bit integer shifts, thus the channels are merged per 128 bit half */
+      const __m256i ir = _mm256_cvttps_epi32(min(max(avxf(_mm256_loadu_ps(r+i))*upper,lower),upper));
+      const __m256i ig = _mm256_cvttps_epi32(min(max(avxf(_mm256_loadu_ps(g+i))*upper,lower),upper));
+      const __m256i ib = _mm256_cvttps_epi32(min(max(avxf(_mm256_loadu_ps(b+i))*upper,lower),upper));
+      const __m128i c0 = _mm_or_si128(_mm256_castsi256_si128(ir),_mm_or_si128(_mm_slli_epi32(_mm256_castsi256_si128(ig),8),_mm_slli_epi32(_mm256_castsi256_si128(ib),16)));
+      const __m128i c1 = _mm_or_si128(_mm256_extractf128_si256(ir,1),_mm_or_si128(_mm_slli_epi32(_mm256_extractf128_si256(ig,1),8),_mm_slli_epi32(_mm256_extractf128_si256(ib,1),16)));
+      _mm_storeu_si128((__m128i*)(pixel+4*i+ 0),c0);
+      _mm_storeu_si128((__m128i*)(pixel+4*i+16),c1);
+    }
+    return i;
+  }
+}
@@ -56,8 +56,8 @@ namespace embree
 
   public:
 
-    BackendScene (RTCScene scene)
-      : scene(scene) {}
+    BackendScene (RTCScene scene, const BBox3f& bounds = empty)
+      : scene(scene), bounds(bounds) {}
 
     ~BackendScene () {
       if (scene) rtcDeleteScene(scene);
@@ -77,6 +77,7 @@ namespace embree
     std::vector<Ref<Light> > allLights;              //!< All lights of the scene
     std::vector<Ref<EnvironmentLight> > envLights;   //!< Environment lights of the scene
     RTCScene scene;
+    BBox3f bounds;                                   //!< Bounds of the scene geometry
   };
 }
 
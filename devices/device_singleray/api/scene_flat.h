@@ -74,14 +74,15 @@ namespace embree
       void create() 
       {
         RTCScene scene = rtcNewScene(RTC_SCENE_STATIC,RTC_INTERSECT1);
+        BBox3f bounds = empty;
         for (size_t i=0; i<prims.size(); i++) {
           if (prims[i] && prims[i]->shape)
-            prims[i]->shape->extract(scene,i);
+            bounds.grow(prims[i]->shape->extract(scene,i));
         }
         rtcCommit(scene);
         
         /* create new scene */
-        instance = new BackendSceneFlat(prims,scene);
+        instance = new BackendSceneFlat(prims,scene,bounds);
       }
       
     public:
@@ -89,8 +90,8 @@ namespace embree
     };
         
     /*! Construction of scene. */
-    BackendSceneFlat (const std::vector<Ref<Primitive> >& geometry, RTCScene scene)
-      : BackendScene(scene), geometry(geometry)
+    BackendSceneFlat (const std::vector<Ref<Primitive> >& geometry, RTCScene scene, const BBox3f& bounds)
+      : BackendScene(scene,bounds), geometry(geometry)
     {
       for (size_t i=0; i<geometry.size(); i++) {
         const Ref<Primitive>& prim = geometry[i];
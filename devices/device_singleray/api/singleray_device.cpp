@@ -16,6 +16,7 @@
 
 #include "singleray_device.h"
 #include "image/image.h"
+#include "image/compressed.h"
 #include "sys/taskscheduler.h"
 
 /* include general stuff */
@@ -33,6 +34,8 @@
 /* include all cameras */
 #include "cameras/pinholecamera.h"
 #include "cameras/depthoffieldcamera.h"
+#include "cameras/distortioncamera.h"
+#include "cameras/stereocamera.h"
 
 /* include all lights */
 #include "lights/ambientlight.h"
@@ -42,6 +45,7 @@
 #include "lights/distantlight.h"
 #include "lights/hdrilight.h"
 #include "lights/trianglelight.h"
+#include "lights/meshlight.h"
 
 /* include all materials */
 #include "materials/matte.h"
@@ -64,6 +68,8 @@
 
 /* include all textures */
 #include "textures/nearestneighbor.h"
+#include "textures/mipmap.h"
+#include "textures/paged.h"
 
 /* include all tonemappers */
 #include "tonemappers/defaulttonemapper.h"
@@ -98,6 +104,7 @@ namespace embree
   int g_serverCount = 1;
   int g_serverID = 0;
   size_t g_time = 0;
+  std::string g_imageCompression = "none"; //!< storage format for new images
 
   /*******************************************************************
                   type definitions
@@ -165,6 +172,8 @@ namespace embree
     RT_COMMAND_HEADER;
     if      (!strcasecmp(type,"pinhole")) return (Device::RTCamera) new ConstructorHandle<PinHoleCamera,Camera>;
     else if (!strcasecmp(type,"depthoffield")) return (Device::RTCamera) new ConstructorHandle<DepthOfFieldCamera,Camera>;
+    else if (!strcasecmp(type,"distortion")) return (Device::RTCamera) new ConstructorHandle<DistortionCamera,Camera>;
+    else if (!strcasecmp(type,"stereo")) return (Device::RTCamera) new ConstructorHandle<StereoCamera,Camera>;
     else throw std::runtime_error("unknown camera type: "+std::string(type));
   }
 
@@ -207,11 +216,13 @@ namespace embree
   Device::RTImage SingleRayDevice::rtNewImage(const char* type, size_t width, size_t height, const void* data, const bool copy)
   {
     RT_COMMAND_HEADER;
-    if      (!strcasecmp(type,"RGB8"        )) return (Device::RTImage) new ConstHandle<Image>(new Image3c(width,height,(Col3c*)data,copy));
-    else if (!strcasecmp(type,"RGBA8"       )) return (Device::RTImage) new ConstHandle<Image>(new Image4c(width,height,(Col4c*)data,copy));
-    else if (!strcasecmp(type,"RGB_FLOAT32" )) return (Device::RTImage) new ConstHandle<Image>(new Image3f(width,height,(Col3f*)data,copy));
-    else if (!strcasecmp(type,"RGBA_FLOAT32")) return (Device::RTImage) new ConstHandle<Image>(new Image4f(width,height,(Col4f*)data,copy));
+    Ref<Image> image;
+    if      (!strcasecmp(type,"RGB8"        )) image = new Image3c(width,height,(Col3c*)data,copy);
+    else if (!strcasecmp(type,"RGBA8"       )) image = new Image4c(width,height,(Col4c*)data,copy);
+    else if (!strcasecmp(type,"RGB_FLOAT32" )) image = new Image3f(width,height,(Col3f*)data,copy);
+    else if (!strcasecmp(type,"RGBA_FLOAT32")) image = new Image4f(width,height,(Col4f*)data,copy);
     else throw std::runtime_error("unknown image type: "+std::string(type));
+    return (Device::RTImage) new ConstHandle<Image>(compressImage(image,g_imageCompression));
   }
 
   Device::RTImage SingleRayDevice::rtNewImageFromFile(const char* file)
@@ -221,9 +232,10 @@ namespace embree
       throw std::runtime_error("rtNewImageFromFile not supported on MIC");
 #else
     if (!strncmp(file,"server:",7)) file += 7;
-    Ref<Image> image = loadImage(file);
+    Ref<Image> image = loadImage(file,true);
+    evictImage(file); // the device keeps its own reference or copy
     if (image) 
-      return (Device::RTImage) new ConstHandle<Image>(image);
+      return (Device::RTImage) new ConstHandle<Image>(compressImage(image,g_imageCompression));
     else
       return (Device::RTImage) new ConstHandle<Image>(new Image3c(1,1,Col3c(255,255,255)));
 #endif
@@ -232,7 +244,9 @@ namespace embree
   Device::RTTexture SingleRayDevice::rtNewTexture(const char* type) {
     RT_COMMAND_HEADER;
     if (!strcasecmp(type,"nearest")) return (Device::RTTexture) new ConstructorHandle<NearestNeighbor,Texture>;
-    else if (!strcasecmp(type,"image")) return (Device::RTTexture) new ConstructorHandle<NearestNeighbor,Texture>;
+    else if (!strcasecmp(type,"mipmap")) return (Device::RTTexture) new ConstructorHandle<MipMap,Texture>;
+    else if (!strcasecmp(type,"paged")) return (Device::RTTexture) new ConstructorHandle<Paged,Texture>;
+    else if (!strcasecmp(type,"image")) return (Device::RTTexture) new ConstructorHandle<MipMap,Texture>;
     else throw std::runtime_error("unsupported texture type: "+std::string(type));
   }
 
@@ -274,6 +288,7 @@ namespace embree
     else if (!strcasecmp(type,"distantlight"    )) return (Device::RTLight) new ConstructorHandle<DistantLight,Light>;
     else if (!strcasecmp(type,"hdrilight"       )) return (Device::RTLight) new ConstructorHandle<HDRILight,Light>;
     else if (!strcasecmp(type,"trianglelight"   )) return (Device::RTLight) new ConstructorHandle<TriangleLight,Light>;
+    else if (!strcasecmp(type,"meshlight"       )) return (Device::RTLight) new ConstructorHandle<MeshLight,Light>;
     else throw std::runtime_error("unknown light type: "+std::string(type));
   }
 
@@ -352,6 +367,7 @@ namespace embree
     if      (!strcasecmp(type,"RGB_FLOAT32")) swapchain = new SwapChain(type,width,height,buffers,ptrs,FrameBufferRGBFloat32::create);
     else if (!strcasecmp(type,"RGBA8"      )) swapchain = new SwapChain(type,width,height,buffers,ptrs,FrameBufferRGBA8     ::create);
     else if (!strcasecmp(type,"RGB8"       )) swapchain = new SwapChain(type,width,height,buffers,ptrs,FrameBufferRGB8      ::create);
+    else if (!strcasecmp(type,"RGBA_HALF16")) swapchain = new SwapChain(type,width,height,buffers,ptrs,FrameBufferRGBAHalf16::create);
     else throw std::runtime_error("unknown framebuffer type: "+std::string(type));
     return (Device::RTFrameBuffer) new ConstHandle<SwapChain>(swapchain);
   }
@@ -425,6 +441,7 @@ namespace embree
     if (!handle  ) {
       if      (!strcmp(property,"serverID"   )) g_serverID = x;
       else if (!strcmp(property,"serverCount")) g_serverCount = x;
+      else if (!strcmp(property,"textureCacheSize")) TileCache::instance().setMaxBytes(size_t(x) << 20);
       return;
     }
     ((_RTHandle*)handle)->set(property,Variant(x));
@@ -505,7 +522,10 @@ namespace embree
   void SingleRayDevice::rtSetString(Device::RTHandle handle, const char* property, const char* str) {
     RT_COMMAND_HEADER;
     if (!property) throw std::runtime_error("invalid property");
-    if (!handle  ) return;
+    if (!handle  ) {
+      if (!strcmp(property,"imageCompression")) g_imageCompression = str;
+      return;
+    }
     ((_RTHandle*)handle)->set(property,Variant(str));
   }
 
@@ -569,6 +589,35 @@ namespace embree
     renderer->getInstance()->renderFrame(camera->getInstance(),scene->getInstance(),toneMapper->getInstance(),frameBuffer->getInstance(),accumulate);
   }
 
+  void SingleRayDevice::rtRenderFrameAsync(Device::RTRenderer renderer_i, Device::RTCamera camera_i,
+                                           Device::RTScene scene_i, Device::RTToneMapper toneMapper_i, 
+                                           Device::RTFrameBuffer frameBuffer_i, int accumulate, volatile int* cancel)
+  {
+    RT_COMMAND_HEADER;
+
+    /* extract objects from handles */
+    Ref<InstanceHandle<Renderer> >      renderer    = castHandle<InstanceHandle<Renderer     > >(renderer_i   ,"renderer"   );
+    Ref<InstanceHandle<Camera> >        camera      = castHandle<InstanceHandle<Camera       > >(camera_i     ,"camera"     );
+    Ref<BackendScene::Handle >          scene       = castHandle<BackendScene::Handle>          (scene_i      ,"scene"      );
+    Ref<InstanceHandle<ToneMapper> >    toneMapper  = castHandle<InstanceHandle<ToneMapper   > >(toneMapper_i ,"tonemapper" );
+    Ref<ConstHandle<SwapChain> > frameBuffer = castHandle<ConstHandle<SwapChain> >(frameBuffer_i,"framebuffer");
+
+    /* start rendering the frame */
+    renderer->getInstance()->renderFrameAsync(camera->getInstance(),scene->getInstance(),toneMapper->getInstance(),frameBuffer->getInstance(),accumulate,cancel);
+  }
+
+  bool SingleRayDevice::rtFrameReady(Device::RTFrameBuffer frameBuffer_i)
+  {
+    RT_COMMAND_HEADER;
+    return castHandle<ConstHandle<SwapChain> >(frameBuffer_i,"framebuffer")->getInstance()->ready();
+  }
+
+  void SingleRayDevice::rtWaitFrame(Device::RTFrameBuffer frameBuffer_i)
+  {
+    RT_COMMAND_HEADER;
+    castHandle<ConstHandle<SwapChain> >(frameBuffer_i,"framebuffer")->getInstance()->wait();
+  }
+
   bool SingleRayDevice::rtPick(Device::RTCamera camera_i, float x, float y, Device::RTScene scene_i, float& px, float& py, float& pz)
   {
     RT_COMMAND_HEADER;
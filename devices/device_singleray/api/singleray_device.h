@@ -90,6 +90,9 @@ namespace embree
     *******************************************************************/
     
     void rtRenderFrame(RTRenderer renderer, RTCamera camera, RTScene scene, RTToneMapper toneMapper, RTFrameBuffer frameBuffer, int accumulate);
+    void rtRenderFrameAsync(RTRenderer renderer, RTCamera camera, RTScene scene, RTToneMapper toneMapper, RTFrameBuffer frameBuffer, int accumulate, volatile int* cancel);
+    bool rtFrameReady(RTFrameBuffer frameBuffer);
+    void rtWaitFrame(RTFrameBuffer frameBuffer);
     bool rtPick(RTCamera camera, float x, float y, RTScene scene, float& px, float& py, float& pz);
 
   private:
@@ -75,6 +75,19 @@ namespace embree
       _buffer[buf]->wait();
     }
 
+    /*! returns true if no buffer gets rendered */
+    bool ready() {
+      for (size_t i=0; i<depth; i++)
+        if (!_buffer[i]->ready()) return false;
+      return true;
+    }
+
+    /*! waits until no buffer gets rendered */
+    void wait() {
+      for (size_t i=0; i<depth; i++)
+        _buffer[i]->wait();
+    }
+
     /*! Clear a part of the framebuffer. */
     void clear(Vec2i start, Vec2i end) 
     {
@@ -95,6 +108,11 @@ namespace embree
       return _accu->update(x,y,color,weight,accumulate);
     }
 
+    /*! accumulate n consecutive pixels of a row inside accumulation buffer, returns the normalized colors in place */
+    void update(size_t x, size_t y, float* r, float* g, float* b, size_t n, const float weight, const bool accumulate) {
+      _accu->update(x,y,r,g,b,n,weight,accumulate);
+    }
+
     /*! returns framebuffer format */
     __forceinline std::string getFormat() const { return format; }
 
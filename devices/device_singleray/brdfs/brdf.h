@@ -18,6 +18,7 @@
 #define __EMBREE_BRDF_H__
 
 #include "../shapes/differentialgeometry.h"
+#include "../brdfs/optics.h"
 
 namespace embree {
 
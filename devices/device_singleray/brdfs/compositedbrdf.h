@@ -18,6 +18,11 @@
 #define __EMBREE_COMPOSITED_BRDF_H__
 
 #include "../brdfs/brdf.h"
+#include "../brdfs/lambertian.h"
+#include "../brdfs/dielectric.h"
+#include "../brdfs/dielectriclayer.h"
+#include "../brdfs/conductor.h"
+#include "../brdfs/microfacet.h"
 
 /*! Helper makro that allocates memory in the composited BRDF and
  *  performs an inplace new of the BRDF to create. */
@@ -30,36 +35,66 @@ namespace embree
   /*! Composited BRDF deals as container of individual BRDF
    *  components. It contains storage where its BRDF components are
    *  allocated inside. It has to be aligned, because the BRDF
-   *  components might use SSE code. */
+   *  components might use SSE code. The BRDFs of the common materials
+   *  are tagged when added and dispatched through a switch over the
+   *  tag, such that their eval and sample functions are called
+   *  without a virtual call and can get inlined. All other BRDFs use
+   *  the virtual interface. */
   class __align(64) CompositedBRDF
   {
     /*! maximal number of BRDF components */
     enum { maxComponents = 8 };
 
-    /*! maximal number of bytes for BRDF storage */
-    enum { maxBytes = 1024*sizeof(float) };
+    /*! maximal number of bytes for BRDF storage, fits maxComponents
+     *  of the largest BRDFs */
+    enum { maxBytes = 384*sizeof(float) };
+
+    /*! BRDF types that are dispatched statically */
+    typedef Microfacet<FresnelDielectric,PowerCosineDistribution> MicrofacetDielectric;
+    typedef Microfacet<FresnelConductor ,PowerCosineDistribution> MicrofacetConductor;
+    typedef DielectricLayer<Lambertian         > LayeredLambertian;
+    typedef DielectricLayer<MicrofacetConductor> LayeredMicrofacetConductor;
+
+    /*! Tag of a BRDF component that selects the implementation to call. */
+    enum Closure {
+      VIRTUAL,                        //!< any other BRDF, called through virtual interface
+      LAMBERTIAN,
+      LAYERED_LAMBERTIAN,
+      DIELECTRIC_REFLECTION,
+      DIELECTRIC_TRANSMISSION,
+      CONDUCTOR,
+      MICROFACET_DIELECTRIC,
+      MICROFACET_CONDUCTOR,
+      LAYERED_MICROFACET_CONDUCTOR
+    };
 
   public:
 
     /*! Composited BRDF constructor. */
     __forceinline CompositedBRDF() : numBytes(0), numBRDFs(0) {}
 
-    /*! Allocates data for new BRDF component. Data gets aligned by 64
+    /*! Allocates data for new BRDF component. Data gets aligned by 16
      *  bytes. */
     __forceinline void* alloc(size_t size) 
     {
       void* p = &data[numBytes];
-      numBytes = (numBytes+size+63)&(size_t(-64));
+      numBytes = (numBytes+size+15)&(size_t(-16));
       if (numBytes>maxBytes) 
         throw std::runtime_error("out of memory for BRDF allocation");
       return p;
     }
 
-    /*! Adds a new BRDF to the list of BRDFs */
-    __forceinline void add(const BRDF* brdf) {
-      assert(numBRDFs < maxComponents);
-      if (numBRDFs < maxComponents) BRDFs[numBRDFs++] = brdf;
-    }
+    /*! Adds a new BRDF to the list of BRDFs. The overloads tag the
+     *  BRDFs that are dispatched statically. */
+    __forceinline void add(const BRDF*                       brdf) { add(brdf,VIRTUAL); }
+    __forceinline void add(const Lambertian*                 brdf) { add(brdf,LAMBERTIAN); }
+    __forceinline void add(const LayeredLambertian*          brdf) { add(brdf,LAYERED_LAMBERTIAN); }
+    __forceinline void add(const DielectricReflection*       brdf) { add(brdf,DIELECTRIC_REFLECTION); }
+    __forceinline void add(const DielectricTransmission*     brdf) { add(brdf,DIELECTRIC_TRANSMISSION); }
+    __forceinline void add(const Conductor*                  brdf) { add(brdf,CONDUCTOR); }
+    __forceinline void add(const MicrofacetDielectric*       brdf) { add(brdf,MICROFACET_DIELECTRIC); }
+    __forceinline void add(const MicrofacetConductor*        brdf) { add(brdf,MICROFACET_CONDUCTOR); }
+    __forceinline void add(const LayeredMicrofacetConductor* brdf) { add(brdf,LAYERED_MICROFACET_CONDUCTOR); }
 
     /*! Returns the number of used BRDF components. */
     __forceinline size_t size() const { return numBRDFs; }
@@ -72,7 +107,7 @@ namespace embree
     {
       Color c = zero;
       for (size_t i=0; i<size(); i++)
-        if (BRDFs[i]->type & type) c += BRDFs[i]->eval(wo,dg,wi);
+        if (BRDFs[i]->type & type) c += evalComponent(i,wo,dg,wi);
       return c;
     }
 
@@ -108,7 +143,7 @@ namespace embree
       for (size_t i = 0; i<size(); i++)
       {
         if (!(BRDFs[i]->type & type)) continue;
-        Sample3f wi; Color c = BRDFs[i]->sample(wo, dg, wi, s);
+        Sample3f wi; Color c = sampleComponent(i, wo, dg, wi, s);
         if (c == Color(zero) || wi.pdf <= 0.0f) continue;
         sum += f[num] = (c.r + c.g + c.b) * rcp(wi.pdf);
         colors[num] = c;
@@ -144,12 +179,64 @@ namespace embree
 
   private:
 
+    /*! Adds a new BRDF with the specified tag to the list of BRDFs */
+    __forceinline void add(const BRDF* brdf, Closure closure) {
+      assert(numBRDFs < maxComponents);
+      if (numBRDFs < maxComponents) {
+        closures[numBRDFs] = closure;
+        BRDFs[numBRDFs++] = brdf;
+      }
+    }
+
+    /*! Non-virtual calls of the BRDF implementation T. */
+    template<typename T> static __forceinline Color evalT(const BRDF* brdf, const Vector3f& wo, const DifferentialGeometry& dg, const Vector3f& wi) {
+      return static_cast<const T*>(brdf)->T::eval(wo,dg,wi);
+    }
+    template<typename T> static __forceinline Color sampleT(const BRDF* brdf, const Vector3f& wo, const DifferentialGeometry& dg, Sample3f& wi, const Vec2f& s) {
+      return static_cast<const T*>(brdf)->T::sample(wo,dg,wi,s);
+    }
+
+    /*! Evaluates the i'th BRDF component. */
+    __forceinline Color evalComponent(size_t i, const Vector3f& wo, const DifferentialGeometry& dg, const Vector3f& wi) const
+    {
+      const BRDF* brdf = BRDFs[i];
+      switch (closures[i]) {
+      case LAMBERTIAN                  : return evalT<Lambertian                >(brdf,wo,dg,wi);
+      case LAYERED_LAMBERTIAN          : return evalT<LayeredLambertian         >(brdf,wo,dg,wi);
+      case DIELECTRIC_REFLECTION       : return evalT<DielectricReflection      >(brdf,wo,dg,wi);
+      case DIELECTRIC_TRANSMISSION     : return evalT<DielectricTransmission    >(brdf,wo,dg,wi);
+      case CONDUCTOR                   : return evalT<Conductor                 >(brdf,wo,dg,wi);
+      case MICROFACET_DIELECTRIC       : return evalT<MicrofacetDielectric      >(brdf,wo,dg,wi);
+      case MICROFACET_CONDUCTOR        : return evalT<MicrofacetConductor       >(brdf,wo,dg,wi);
+      case LAYERED_MICROFACET_CONDUCTOR: return evalT<LayeredMicrofacetConductor>(brdf,wo,dg,wi);
+      default                          : return brdf->eval(wo,dg,wi);
+      }
+    }
+
+    /*! Samples the i'th BRDF component. */
+    __forceinline Color sampleComponent(size_t i, const Vector3f& wo, const DifferentialGeometry& dg, Sample3f& wi, const Vec2f& s) const
+    {
+      const BRDF* brdf = BRDFs[i];
+      switch (closures[i]) {
+      case LAMBERTIAN                  : return sampleT<Lambertian                >(brdf,wo,dg,wi,s);
+      case LAYERED_LAMBERTIAN          : return sampleT<LayeredLambertian         >(brdf,wo,dg,wi,s);
+      case DIELECTRIC_REFLECTION       : return sampleT<DielectricReflection      >(brdf,wo,dg,wi,s);
+      case DIELECTRIC_TRANSMISSION     : return sampleT<DielectricTransmission    >(brdf,wo,dg,wi,s);
+      case CONDUCTOR                   : return sampleT<Conductor                 >(brdf,wo,dg,wi,s);
+      case MICROFACET_DIELECTRIC       : return sampleT<MicrofacetDielectric      >(brdf,wo,dg,wi,s);
+      case MICROFACET_CONDUCTOR        : return sampleT<MicrofacetConductor       >(brdf,wo,dg,wi,s);
+      case LAYERED_MICROFACET_CONDUCTOR: return sampleT<LayeredMicrofacetConductor>(brdf,wo,dg,wi,s);
+      default                          : return brdf->sample(wo,dg,wi,s);
+      }
+    }
+
     /*! Data storage. Has to be at the beginning of the class due to alignment. */
     char data[maxBytes];               //!< Storage for BRDF components
     size_t numBytes;                   //!< Number of bytes occupied in storage
 
     /*! BRDF list */
     const BRDF* BRDFs[maxComponents]; //!< pointers to BRDF components
+    Closure closures[maxComponents];  //!< tags of BRDF components
     size_t numBRDFs;                  //!< number of stored BRDF components
   };
 }
@@ -52,6 +52,24 @@ namespace embree
       return Fo * T * Fg * T * Fi;
     }
 
+    /*! Evaluates the BRDF for a SIMD packet of hit points. */
+    template<typename F> __forceinline Vec3<F> eval(const Vec3<F>& wo, const Vec3<F>& Ng, const Vec3<F>& Ns, const Vec3<F>& wi) const
+    {
+      const F cosThetaO = dot(wo,Ns);
+      const F cosThetaI = dot(wi,Ns);
+      const F ko = F(one)-etait*etait*(F(one)-cosThetaO*cosThetaO);
+      const F ki = F(one)-etait*etait*(F(one)-cosThetaI*cosThetaI);
+      const F cosThetaO1 = sqrt(max(ko,F(zero)));
+      const F cosThetaI1 = sqrt(max(ki,F(zero)));
+      const Vec3<F> wo1 = F(etait)*(cosThetaO*Ns - wo) - cosThetaO1*Ns;
+      const Vec3<F> wi1 = F(etait)*(cosThetaI*Ns - wi) - cosThetaI1*Ns;
+      const F Fi = F(one) - fresnelDielectric(cosThetaI,cosThetaI1,etait);
+      const Vec3<F> Fg = ground.eval(-wo1,Ng,Ns,-wi1);
+      const F Fo = F(one) - fresnelDielectric(cosThetaO,cosThetaO1,etait);
+      const F valid = select((cosThetaI > F(zero)) & (cosThetaO > F(zero)) & (ko >= F(zero)) & (ki >= F(zero)), Fo*Fi, F(zero));
+      return packet<F>(T*T) * Fg * valid;
+    }
+
     Color sample(const Vector3f& wo, const DifferentialGeometry& dg, Sample3f& wi, const Vec2f& s) const
     {
       /*! refract ray into medium */
@@ -36,6 +36,11 @@ namespace embree
       return R * (1.0f/float(pi)) * clamp(dot(wi,dg.Ns));
     }
 
+    /*! Evaluates the BRDF for a SIMD packet of hit points. */
+    template<typename T> __forceinline Vec3<T> eval(const Vec3<T>& wo, const Vec3<T>& Ng, const Vec3<T>& Ns, const Vec3<T>& wi) const {
+      return packet<T>(R) * (T(1.0f/float(pi)) * clamp(dot(wi,Ns)));
+    }
+
     Color sample(const Vector3f& wo, const DifferentialGeometry& dg, Sample3f& wi, const Vec2f& s) const {
       return eval(wo, dg, wi = cosineSampleHemisphere(s.x,s.y,dg.Ns));
     }
@@ -55,6 +55,22 @@ namespace embree
       return R * D * G * F * rcp(4.0f*cosThetaO);
     }
 
+    /*! Evaluates the BRDF for a SIMD packet of hit points. */
+    template<typename T> __forceinline Vec3<T> eval(const Vec3<T>& wo, const Vec3<T>& Ng, const Vec3<T>& Ns, const Vec3<T>& wi) const
+    {
+      const T cosThetaO = dot(wo,Ns);
+      const T cosThetaI = dot(wi,Ns);
+      const Vec3<T> wh = normalize(wi + wo);
+      const T cosThetaH = dot(wh, Ns);
+      const T cosTheta = dot(wi, wh); // = dot(wo, wh);
+      const Vec3<T> F = fresnel.eval(cosTheta);
+      const T D = distribution.eval(wh,Ns);
+      const T rcpCosTheta = rcp(cosTheta);
+      const T G = min(T(one), min(T(2.0f) * cosThetaH * cosThetaO * rcpCosTheta, T(2.0f) * cosThetaH * cosThetaI * rcpCosTheta));
+      const T f = select((dot(wi,Ng) > T(zero)) & (cosThetaI > T(zero)) & (cosThetaO > T(zero)), D * G * rcp(T(4.0f)*cosThetaO), T(zero));
+      return packet<T>(R) * F * f;
+    }
+
     Color sample(const Vector3f& wo, const DifferentialGeometry& dg, Sample3f& wi, const Vec2f& s) const
     {
       if (dot(wo,dg.Ns) <= 0.0f) return zero;
@@ -82,6 +82,11 @@ namespace embree
       return Color(fresnelDielectric(cosTheta,etai*rcp(etat)));
     }
 
+    /*! Evaluates the fresnel term for a SIMD packet of cosines. */
+    template<typename T> __forceinline Vec3<T> eval(const T& cosTheta) const {
+      return Vec3<T>(fresnelDielectric(cosTheta,etai*rcp(etat)));
+    }
+
   private:
 
     /*! refraction index of the medium the incident ray travels in */
@@ -105,6 +110,9 @@ namespace embree
      *  between the facet normal (half vector) and the viewing
      *  vector. */
     __forceinline Color eval(float cosTheta) const { return fresnelConductor(cosTheta,eta,k); }
+
+    /*! Evaluates the fresnel term for a SIMD packet of cosines. */
+    template<typename T> __forceinline Vec3<T> eval(const T& cosTheta) const { return fresnelConductor(cosTheta,eta,k); }
   private:
     const Color eta;  //!< Real part of refraction index
     const Color k;    //!< Imaginary part of refraction index
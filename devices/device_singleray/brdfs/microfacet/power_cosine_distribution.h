@@ -37,6 +37,14 @@ namespace embree
       return norm2 * pow(abs(cosTheta),n);
     }
 
+    /*! Evaluates the power cosine distribution for a SIMD packet of
+     *  half vectors wh and z-directions dz. */
+    template<typename T> __forceinline T eval(const Vec3<T>& wh, const Vec3<T>& dz) const
+    {
+      const T cosTheta = dot(wh,dz);
+      return T(norm2) * pow(abs(cosTheta),T(n));
+    }
+
     /*! Samples the distribution. \param s is the sample location
      *  provided by the caller. */
     __forceinline Sample3f sample(const Vec2f& s) const
@@ -26,6 +26,11 @@
 
 namespace embree
 {
+  /*! Broadcasts a color into a SIMD packet of colors in SoA layout. */
+  template<typename T> __forceinline Vec3<T> packet(const Color& c) {
+    return Vec3<T>(T(c.r),T(c.g),T(c.b));
+  }
+
   /*! Reflects a viewing vector V at a normal N. */
   __forceinline Sample3f reflect(const Vector3f& V, const Vector3f& N) {
     float cosi = dot(V,N);
@@ -128,6 +133,41 @@ namespace embree
       rcp(tmp + 2.0f*eta*cosi + Color(cosi*cosi));
     return 0.5f * (Rpar + Rper);
   }
+
+  /*! Computes fresnel coefficients for a SIMD packet of cosines. Eta
+   *  is the relative refraction index. Both cosines have to be
+   *  positive. */
+  template<typename T> __forceinline T fresnelDielectric(const T& cosi, const T& cost, const float eta)
+  {
+    const T Rper = (eta*cosi -     cost) * rcp(eta*cosi +     cost);
+    const T Rpar = (    cosi - eta*cost) * rcp(    cosi + eta*cost);
+    return T(0.5f)*(Rpar*Rpar + Rper*Rper);
+  }
+
+  /*! Computes fresnel coefficients for a SIMD packet of cosines and
+   *  relative refraction index eta, including total internal
+   *  reflection. The cosines have to be positive. */
+  template<typename T> __forceinline T fresnelDielectric(const T& cosi, const float eta)
+  {
+    const T k = T(one)-eta*eta*(T(one)-cosi*cosi);
+    const T cost = sqrt(max(k,T(zero)));
+    return select(k < T(zero), T(one), fresnelDielectric(cosi, cost, eta));
+  }
+
+  /*! Computes fresnel coefficients for a SIMD packet of cosines and a
+   *  conductor medium with complex refraction index (eta,k). The
+   *  cosines have to be positive. */
+  template<typename T> __forceinline Vec3<T> fresnelConductor(const T& cosi, const Color& eta, const Color& k)
+  {
+    const Vec3<T> eta1 = packet<T>(eta);
+    const Vec3<T> tmp = packet<T>(eta*eta + k*k);
+    const T cosi2 = cosi*cosi;
+    const Vec3<T> Rpar = (tmp*cosi2 - T(2.0f)*cosi*eta1 + Vec3<T>(T(one))) *
+      rcp(tmp*cosi2 + T(2.0f)*cosi*eta1 + Vec3<T>(T(one)));
+    const Vec3<T> Rper = (tmp - T(2.0f)*cosi*eta1 + Vec3<T>(cosi2)) *
+      rcp(tmp + T(2.0f)*cosi*eta1 + Vec3<T>(cosi2));
+    return T(0.5f) * (Rpar + Rper);
+  }
 }
 
 #endif
@@ -38,6 +38,15 @@ namespace embree
       return R * (exp+2) * (1.0f/(2.0f*float(pi))) * pow(dot(r,wi),exp) * clamp(dot(wi,dg.Ns));
     }
 
+    /*! Evaluates the BRDF for a SIMD packet of hit points. */
+    template<typename T> __forceinline Vec3<T> eval(const Vec3<T>& wo, const Vec3<T>& Ng, const Vec3<T>& Ns, const Vec3<T>& wi) const {
+      const T cosi = dot(wo,Ns);
+      const Vec3<T> r = T(2.0f)*cosi*Ns-wo;
+      const T cosr = dot(r,wi);
+      const T f = T((exp+2) * (1.0f/(2.0f*float(pi)))) * pow(max(cosr,T(1E-30f)),T(exp)) * clamp(dot(wi,Ns));
+      return packet<T>(R) * select(cosr < T(zero), T(zero), f);
+    }
+
     Color sample(const Vector3f& wo, const DifferentialGeometry& dg, Sample3f& wi, const Vec2f& s) const {
       return eval(wo, dg, wi = powerCosineSampleHemisphere(s.x,s.y,reflect(wo,dg.Ns),exp));
     }
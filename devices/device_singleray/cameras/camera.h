@@ -30,13 +30,48 @@ namespace embree
     /*! Virtual interface destructor. */
     virtual ~Camera() {}
 
-    /*! Computes a primary ray for a pixel. */
+    /*! Computes a primary ray for a pixel. The ray differentials are
+     *  set with respect to the pixel location in the range from 0 to 1. */
     virtual void ray(const Vec2f& pixel,  /*!< The pixel location on the on image plane in the range from 0 to 1. */
                      const Vec2f& sample, /*!< The lens sample in [0,1) for depth of field. */
                      Ray& ray_o)          /*!< To return the ray. */ const = 0;
 
+    /*! Computes the primary ray of a single color channel (0 = red,
+     *  1 = green, 2 = blue) for cameras with chromatic aberration. */
+    virtual void ray(const Vec2f& pixel, const Vec2f& sample, int channel, Ray& ray_o) const { 
+      ray(pixel,sample,ray_o); 
+    }
+
+    /*! Returns true if each color channel needs its own primary ray. */
+    virtual bool chromatic() const { return false; }
+
+    /*! Returns false if no light reaches the pixel through the lens. */
+    virtual bool visible(const Vec2f& pixel) const { return true; }
+
+    /*! Returns the number of views rendered side by side into the image. */
+    virtual size_t numViews() const { return 1; }
+
+    /*! Returns the camera of a view, pixel locations of views range from 0 to 1. */
+    virtual const Camera* view(size_t i) const { return this; }
+
+    /*! Projects a point to its pixel location in the range from 0 to
+     *  1. Returns false if the point is behind the camera or the
+     *  camera cannot project points. */
+    virtual bool project(const Vector3f& p, Vec2f& pixel) const { return false; }
+
     /*! Field of view. */
     float angle;
+
+  protected:
+
+    /*! Sets the ray differentials from the unnormalized ray direction
+     *  d and its derivatives dddx and dddy. */
+    static __forceinline void setDifferentials(const Vector3f& d, const Vector3f& dddx, const Vector3f& dddy, Ray& ray_o)
+    {
+      const float d2 = dot(d,d), s = rsqrt(d2)*rcp(d2);
+      ray_o.dDdx = s*(d2*dddx - dot(d,dddx)*d);
+      ray_o.dDdy = s*(d2*dddy - dot(d,dddy)*d);
+    }
   };
 }
 
@@ -39,6 +39,7 @@ namespace embree
       Vector3f begin = xfmPoint(local2world, Vector3f(lens.x,lens.y,0.0f));
       Vector3f end   = pixel2world.p + focalDistance*(pixel.x*pixel2world.l.vx + (1.0f-pixel.y)*pixel2world.l.vy + pixel2world.l.vz);
       new (&ray_o) Ray(begin, normalize(end - begin));
+      setDifferentials(end - begin,focalDistance*pixel2world.l.vx,-focalDistance*pixel2world.l.vy,ray_o);
     }
 
   protected:
@@ -0,0 +1,106 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+#ifndef __EMBREE_DISTORTION_CAMERA_H__
+#define __EMBREE_DISTORTION_CAMERA_H__
+
+#include "pinholecamera.h"
+
+namespace embree
+{
+  /*! Pinhole camera that shoots rays along the barrel distorted
+   *  directions of a head mounted display lens, such that the
+   *  rendered image can get displayed without resampling. The
+   *  defaults match the lens of the Oculus Rift DK1. */
+  class DistortionCamera : public PinHoleCamera
+  {
+  public:
+
+    /*! Construction from parameter container. */
+    DistortionCamera(const Parms& parms) : PinHoleCamera(parms) 
+    {
+      k0 = parms.getFloat("k0",1.0f);
+      k1 = parms.getFloat("k1",0.22f);
+      k2 = parms.getFloat("k2",0.24f);
+      k3 = parms.getFloat("k3",0.0f);
+      chromAbRed  = parms.getVec2f("chromAbRed" ,Vec2f(0.996f,-0.004f));
+      chromAbBlue = parms.getVec2f("chromAbBlue",Vec2f(1.014f, 0.0f));
+      rcpScale = 0.5f*rcp(parms.getFloat("distortionScale",1.714606f));
+      chromaticAberration = parms.getBool("chromatic",false);
+
+      /*! the lens center is shifted towards the nose, stereo type 1 is the right eye */
+      const float offset = parms.getFloat("lensCenterOffset",0.151976f);
+      lensCenter = 0.5f + 0.5f*(parms.getInt("stereoType",0) == 1 ? -offset : offset);
+    }
+
+    void ray(const Vec2f& pixel, const Vec2f& sample, Ray& ray_o) const {
+      ray(pixel,sample,1,ray_o);
+    }
+
+    void ray(const Vec2f& pixel, const Vec2f& sample, int channel, Ray& ray_o) const 
+    {
+      float scale; 
+      const Vec2f p = distort(pixel,chromaticAberration ? channel : 1,scale);
+      const Vector3f dir = p.x*pixel2world.l.vx + (1.0f-p.y)*pixel2world.l.vy + pixel2world.l.vz;
+      new (&ray_o) Ray(pixel2world.p,normalize(dir));
+      setDifferentials(dir,scale*pixel2world.l.vx,-scale*pixel2world.l.vy,ray_o);
+    }
+
+    bool chromatic() const { 
+      return chromaticAberration; 
+    }
+
+    /*! The distortion has no closed form inverse. */
+    bool project(const Vector3f& p, Vec2f& pixel) const {
+      return false;
+    }
+
+    /*! The lens shows the pixel if the blue channel, which gets distorted most, stays inside the undistorted image. */
+    bool visible(const Vec2f& pixel) const {
+      float scale; const Vec2f p = distort(pixel,2,scale);
+      return p.x >= 0.0f && p.x <= 1.0f && p.y >= 0.0f && p.y <= 1.0f;
+    }
+
+  protected:
+
+    /*! Maps a pixel of the distorted image to the undistorted image
+     *  plane of the pinhole camera for the given color channel, and
+     *  returns the local scaling of the mapping for the ray
+     *  differentials. */
+    __forceinline Vec2f distort(const Vec2f& pixel, int channel, float& scale) const
+    {
+      const float tx = 2.0f*(pixel.x-lensCenter);
+      const float ty = 2.0f*(pixel.y-0.5f)*rcp(aspectRatio);
+      const float r2 = tx*tx + ty*ty;
+      float f = k0 + r2*(k1 + r2*(k2 + r2*k3));
+      if      (channel == 0) f *= chromAbRed.x  + chromAbRed.y *r2;
+      else if (channel == 2) f *= chromAbBlue.x + chromAbBlue.y*r2;
+      scale = 2.0f*rcpScale*f;
+      return Vec2f(lensCenter + rcpScale*f*tx, 0.5f + rcpScale*aspectRatio*f*ty);
+    }
+
+  protected:
+    float k0, k1, k2, k3;          //!< coefficients of the radial distortion polynomial
+    Vec2f chromAbRed;              //!< radial scaling of the red channel
+    Vec2f chromAbBlue;             //!< radial scaling of the blue channel
+    float rcpScale;                //!< maps distorted radii back to the image plane
+    float lensCenter;              //!< horizontal lens center in the range from 0 to 1
+    bool chromaticAberration;      //!< trace one primary ray per color channel
+  };
+}
+
+#endif
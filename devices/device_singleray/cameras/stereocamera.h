@@ -0,0 +1,83 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+
+#ifndef __EMBREE_STEREO_CAMERA_H__
+#define __EMBREE_STEREO_CAMERA_H__
+
+#include "pinholecamera.h"
+#include "distortioncamera.h"
+
+namespace embree
+{
+  /*! Renders the views of the left and right eye side by side into a
+   *  single image, such that the renderer processes the corresponding
+   *  tiles of both eyes in one pass. The eyes are pinhole cameras,
+   *  optionally with the lens distortion of a head mounted display. */
+  class StereoCamera : public Camera
+  {
+  public:
+
+    /*! Construction from parameter container. */
+    StereoCamera(const Parms& parms) 
+    {
+      const AffineSpace3f local2world = parms.getTransform("local2world");
+      const Vector3f offset = 0.5f*parms.getFloat("stereoDistance",0.0f)*normalize(local2world.l.vx);
+      angle = parms.getFloat("angle",64.0f);
+
+      /*! eyes are offset along the x axis of the camera */
+      for (int i=0; i<2; i++) {
+        Parms eye = parms;
+        eye.add("stereoType",Variant(i));
+        eye.add("local2world",Variant(AffineSpace3f(local2world.l,i == 0 ? local2world.p-offset : local2world.p+offset)));
+        if (parms.getBool("distortion",false)) eyes[i] = new DistortionCamera(eye);
+        else                                   eyes[i] = new PinHoleCamera(eye);
+      }
+    }
+
+    void ray(const Vec2f& pixel, const Vec2f& sample, Ray& ray_o) const {
+      ray(pixel,sample,1,ray_o);
+    }
+
+    void ray(const Vec2f& pixel, const Vec2f& sample, int channel, Ray& ray_o) const {
+      const size_t i = pixel.x >= 0.5f;
+      eyes[i]->ray(Vec2f(2.0f*pixel.x-float(i),pixel.y),sample,channel,ray_o);
+      ray_o.dDdx = 2.0f*ray_o.dDdx;
+    }
+
+    bool chromatic() const { 
+      return eyes[0]->chromatic(); 
+    }
+
+    bool visible(const Vec2f& pixel) const {
+      const size_t i = pixel.x >= 0.5f;
+      return eyes[i]->visible(Vec2f(2.0f*pixel.x-float(i),pixel.y));
+    }
+
+    size_t numViews() const { 
+      return 2; 
+    }
+
+    const Camera* view(size_t i) const { 
+      return eyes[i].ptr; 
+    }
+
+  protected:
+    Ref<Camera> eyes[2];  //!< cameras of the left and right eye
+  };
+}
+
+#endif
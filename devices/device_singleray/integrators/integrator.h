@@ -33,6 +33,17 @@ namespace embree
     size_t                   numRays; /*!< Used to count the number of rays shot.            */
   };
   
+  /*! Primary ray that is already intersected, the unit of the tile
+   *  level shading stage of the renderer. */
+  struct PrimaryHit
+  {
+    Ray ray;                          /*!< Intersected primary ray.                  */
+    DifferentialGeometry dg;          /*!< Hit point of the ray.                     */
+    const PrecomputedSample* sample;  /*!< Samples used along the path of the ray.   */
+    Vec2f pixel;                      /*!< Normalized pixel location on screen.      */
+    Color L;                          /*!< Radiance computed by the integrator.      */
+  };
+
   /*! Interface to different integrators. The task of the integrator
    *  is to compute the incoming radiance along some ray. */
   class Integrator : public RefCount {
@@ -45,12 +56,36 @@ namespace embree
     /*! Allows the integrator to register required samples at the sampler. */
     virtual void requestSamples(Ref<SamplerFactory>& samplerFactory, const Ref<BackendScene>& scene) {}
 
+    /*! Called once before a frame of the scene is rendered. */
+    virtual void prepare(const Ref<BackendScene>& scene) {}
+
     /*! Computes the radiance arriving at the origin of the ray from
      *  the ray direction. */
     virtual Color Li(      Ray&               ray,     /*!< Ray to compute the radiance along.                */
                      const Ref<BackendScene>& scene,   /*!< Scene geometry and lights.                        */
                      IntegratorState&   state) = 0;
-                     
+
+    /*! Computes the radiance arriving along a ray that is already
+     *  intersected and whose hit point dg is already computed. */
+    virtual Color Li(      Ray&                  ray,     /*!< Intersected ray to compute the radiance along.    */
+                     const DifferentialGeometry& dg,      /*!< Hit point of the ray.                             */
+                     const Ref<BackendScene>&    scene,   /*!< Scene geometry and lights.                        */
+                     IntegratorState&   state) = 0;
+
+    /*! Computes the radiance for the primary rays of a tile at once,
+     *  such that hit points of the same material can be shaded
+     *  together. The default shades each ray on its own. */
+    virtual void Li(PrimaryHit*              hits,    /*!< Intersected primary rays, receive their radiance. */
+                    size_t                   N,       /*!< Number of primary rays.                           */
+                    const Ref<BackendScene>& scene,   /*!< Scene geometry and lights.                        */
+                    IntegratorState&   state)
+    {
+      for (size_t i=0; i<N; i++) {
+        state.sample = hits[i].sample;
+        state.pixel  = hits[i].pixel;
+        hits[i].L = Li(hits[i].ray, hits[i].dg, scene, state);
+      }
+    }
   };
 }
 
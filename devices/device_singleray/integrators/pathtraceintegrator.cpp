@@ -15,9 +15,20 @@
 // ======================================================================== //
 
 #include "integrators/pathtraceintegrator.h"
+#include <algorithm>
 
 namespace embree
 {
+  /*! BRDF components connected to the light sources by shadow rays
+   *  and BRDF components sampled to continue the path. */
+#if 0
+  static const BRDFType directLightingBRDFTypes = (BRDFType)(DIFFUSE|GLOSSY); 
+  static const BRDFType giBRDFTypes = (BRDFType)(SPECULAR);
+#else
+  static const BRDFType directLightingBRDFTypes = (BRDFType)(DIFFUSE); 
+  static const BRDFType giBRDFTypes = (BRDFType)(ALL);
+#endif
+
   PathTraceIntegrator::PathTraceIntegrator(const Parms& parms)
     : lightSampleID(-1), firstScatterSampleID(-1), firstScatterTypeSampleID(-1)
   {
@@ -25,6 +36,18 @@ namespace embree
     minContribution = parms.getFloat("minContribution",0.01f );
     epsilon         = parms.getFloat("epsilon"        ,32.0f)*float(ulp);
     backplate       = parms.getImage("backplate");
+
+    /*! the shadow cache is enabled by specifying its grid cell size */
+    const float shadowCacheCellSize = parms.getFloat("shadowCache",0.0f);
+    if (shadowCacheCellSize > 0.0f) 
+      shadowCache = new ShadowCache(shadowCacheCellSize,parms.getInt("shadowCacheObservations",8));
+
+    /*! path guiding configuration */
+    guiding                     = parms.getInt  ("guiding"                    ,0) != 0;
+    guidingFraction             = parms.getFloat("guidingFraction"            ,0.5f);
+    guidingSpatialThreshold     = parms.getInt  ("guidingSpatialThreshold"    ,12000);
+    guidingDirectionalThreshold = parms.getFloat("guidingDirectionalThreshold",0.01f);
+    guidingPassLength = guidingPassFrames = 0;
   }
   
   void PathTraceIntegrator::requestSamples(Ref<SamplerFactory>& samplerFactory, const Ref<BackendScene>& scene)
@@ -41,6 +64,60 @@ namespace embree
     firstScatterTypeSampleID = samplerFactory->request1D((int)maxDepth);
   }
 
+  void PathTraceIntegrator::prepare(const Ref<BackendScene>& scene)
+  {
+    /*! each scene commit creates a new scene, thus the reference detects changes of geometry and lights */
+    if (scene != cachedScene) 
+    {
+      if (shadowCache) shadowCache->clear();
+      guidingTree = null;
+      if (guiding && !scene->bounds.empty()) guidingTree = new SDTree(scene->bounds);
+      guidingPassLength = 1;
+      guidingPassFrames = 0;
+      cachedScene = scene;
+    }
+
+    /*! training passes double in length, at the end of each pass the
+     *  recorded radiance becomes the guiding distribution */
+    else if (guidingTree && ++guidingPassFrames == guidingPassLength)
+    {
+      const size_t maxSamples = size_t(float(guidingSpatialThreshold)*sqrtf(float(guidingPassLength)));
+      guidingTree->update(maxSamples,guidingDirectionalThreshold,20);
+      guidingPassFrames = 0;
+      guidingPassLength *= 2;
+    }
+  }
+
+  bool PathTraceIntegrator::guidable(const CompositedBRDF& brdfs) const
+  {
+    if (brdfs.size() == 0) return false;
+    for (size_t i=0; i<brdfs.size(); i++)
+      if (brdfs[i]->type != DIFFUSE_REFLECTION) return false;
+    return true;
+  }
+
+  Color PathTraceIntegrator::sampleGuided(const SDTree::Leaf* leaf, const CompositedBRDF& brdfs, const Vector3f& wo, 
+                                          const DifferentialGeometry& dg, Sample3f& wi, const Vec2f& s, float ss) const
+  {
+    /*! leaves guide only once they learned a distribution */
+    const float alpha = leaf->sampling.energy() > 0.0f ? guidingFraction : 0.0f;
+
+    /*! pick the guiding distribution or one BRDF component */
+    if (ss < alpha) wi = leaf->sampling.sample(s);
+    else {
+      const size_t i = min(size_t((ss-alpha)*rcp(1.0f-alpha)*float(brdfs.size())),brdfs.size()-1);
+      brdfs[i]->sample(wo,dg,wi,s);
+    }
+
+    /*! the balance heuristic turns the mixture of both strategies into one PDF */
+    float brdfPdf = 0.0f;
+    for (size_t i=0; i<brdfs.size(); i++) brdfPdf += brdfs[i]->pdf(wo,dg,wi);
+    brdfPdf *= rcp(float(brdfs.size()));
+    const float guidePdf = alpha > 0.0f ? leaf->sampling.pdf(wi) : 0.0f;
+    wi.pdf = alpha*guidePdf + (1.0f-alpha)*brdfPdf;
+    return brdfs.eval(wo,dg,wi,ALL);
+  }
+
   Color PathTraceIntegrator::Li(LightPath& lightPath, const Ref<BackendScene>& scene, IntegratorState& state)
   {
     /*! Terminate path if too long or contribution too low. */
@@ -53,16 +130,15 @@ namespace embree
     rtcIntersect(scene->scene,(RTCRay&)lightPath.lastRay);
     scene->postIntersect(lightPath.lastRay,dg);
     state.numRays++;
-    
+    return shade(lightPath, dg, scene, state);
+  }
+
+  Color PathTraceIntegrator::shade(LightPath& lightPath, DifferentialGeometry& dg, const Ref<BackendScene>& scene, IntegratorState& state,
+                                    bool* deferDirectLighting)
+  {
     Color L = zero;
     const Vector3f wo = -lightPath.lastRay.dir;
-#if 0
-    BRDFType directLightingBRDFTypes = (BRDFType)(DIFFUSE|GLOSSY); 
-    BRDFType giBRDFTypes = (BRDFType)(SPECULAR);
-#else
-    BRDFType directLightingBRDFTypes = (BRDFType)(DIFFUSE); 
-    BRDFType giBRDFTypes = (BRDFType)(ALL);
-#endif
+    if (deferDirectLighting) *deferDirectLighting = false;
 
     /*! Environment shading when nothing hit. */
     if (!lightPath.lastRay)
@@ -101,7 +177,10 @@ namespace embree
       Sample3f wi; BRDFType type;
       Vec2f s  = state.sample->getVec2f(firstScatterSampleID     + lightPath.depth);
       float ss = state.sample->getFloat(firstScatterTypeSampleID + lightPath.depth);
-      Color c = brdfs.sample(wo, dg, wi, type, s, ss, giBRDFTypes);
+      SDTree::Leaf* leaf = guidingTree && guidable(brdfs) ? guidingTree->lookup(dg.P) : NULL;
+      Color c;
+      if (leaf) { c = sampleGuided(leaf, brdfs, wo, dg, wi, s, ss); type = DIFFUSE_REFLECTION; }
+      else c = brdfs.sample(wo, dg, wi, type, s, ss, giBRDFTypes);
 
       /*! Continue only if we hit something valid. */
       if (c != Color(zero) && wi.pdf > 0.0f)
@@ -117,7 +196,9 @@ namespace embree
         /*! Continue the path. */
         LightPath scatteredPath = lightPath.extended(Ray(dg.P, wi, dg.error*epsilon, inf, lightPath.lastRay.time), 
                                                      nextMedium, c, (type & directLightingBRDFTypes) != NONE);
-        L += c * Li(scatteredPath, scene, state) * rcp(wi.pdf);
+        const Color Lin = Li(scatteredPath, scene, state);
+        if (leaf) guidingTree->record(leaf, wi, luminance(Lin)*rcp(wi.pdf));
+        L += c * Lin * rcp(wi.pdf);
       }
     }
 
@@ -126,6 +207,12 @@ namespace embree
     for (size_t i=0; i<brdfs.size(); i++)
       useDirectLighting |= (brdfs[i]->type & directLightingBRDFTypes) != NONE;
 
+    /*! The caller computes direct lighting for many hit points at once. */
+    if (useDirectLighting && deferDirectLighting) {
+      *deferDirectLighting = true;
+      return L;
+    }
+
     /*! Direct lighting. Shoot shadow rays to all light sources. */
     if (useDirectLighting)
     {
@@ -147,12 +234,21 @@ namespace embree
         Color brdf = brdfs.eval(wo, dg, ls.wi, directLightingBRDFTypes);
         if (brdf == Color(zero)) continue;
 
+        /*! Visibility of delta lights may be known from the shadow cache. */
+        const bool cacheable = shadowCache && scene->allLights[i]->delta();
+        const int visibility = cacheable ? shadowCache->lookup(dg.P,i,dg.shadowMask) : int(ShadowCache::UNKNOWN);
+        if (visibility == ShadowCache::OCCLUDED) continue;
+
         /*! Test for shadows. */
-        Ray shadowRay(dg.P, ls.wi, dg.error*epsilon, ls.tMax-dg.error*epsilon, lightPath.lastRay.time,dg.shadowMask);
-        //bool inShadow = scene->intersector->occluded(shadowRay);
-        rtcOccluded(scene->scene,(RTCRay&)shadowRay);
-        state.numRays++;
-        if (shadowRay) continue;
+        if (visibility == ShadowCache::UNKNOWN) 
+        {
+          Ray shadowRay(dg.P, ls.wi, dg.error*epsilon, ls.tMax-dg.error*epsilon, lightPath.lastRay.time,dg.shadowMask);
+          //bool inShadow = scene->intersector->occluded(shadowRay);
+          rtcOccluded(scene->scene,(RTCRay&)shadowRay);
+          state.numRays++;
+          if (cacheable) shadowCache->record(dg.P,i,dg.shadowMask,shadowRay);
+          if (shadowRay) continue;
+        }
 
         /*! Evaluate BRDF. */
         L += ls.L * brdf * rcp(ls.wi.pdf);
@@ -165,5 +261,88 @@ namespace embree
   Color PathTraceIntegrator::Li(Ray& ray, const Ref<BackendScene>& scene, IntegratorState& state) {
     LightPath path(ray); return Li(path,scene,state);
   }
-}
 
+  Color PathTraceIntegrator::Li(Ray& ray, const DifferentialGeometry& dg, const Ref<BackendScene>& scene, IntegratorState& state) {
+    LightPath path(ray); DifferentialGeometry hit = dg; return shade(path,hit,scene,state);
+  }
+
+  void PathTraceIntegrator::Li(PrimaryHit* hits, size_t N, const Ref<BackendScene>& scene, IntegratorState& state)
+  {
+    /*! shade the hit points one by one, but collect the ones that need direct lighting */
+    std::vector<std::pair<Material*,size_t> > deferred;
+    deferred.reserve(N);
+    for (size_t i=0; i<N; i++) 
+    {
+      state.sample = hits[i].sample;
+      state.pixel  = hits[i].pixel;
+      LightPath path(hits[i].ray); 
+      bool direct = false;
+      hits[i].L = shade(path, hits[i].dg, scene, state, &direct);
+      if (direct) deferred.push_back(std::make_pair(hits[i].dg.material,i));
+    }
+
+    /*! compute direct lighting for packets of hit points of the same material */
+    std::sort(deferred.begin(),deferred.end());
+    for (size_t begin=0; begin<deferred.size(); )
+    {
+      size_t end = begin+1;
+      while (end < deferred.size() && end-begin < ShadingPacket::maxSize && deferred[end].first == deferred[begin].first) end++;
+      directLighting(hits, &deferred[begin], end-begin, scene, state);
+      begin = end;
+    }
+  }
+
+  void PathTraceIntegrator::directLighting(PrimaryHit* hits, const std::pair<Material*,size_t>* group, size_t N, 
+                                           const Ref<BackendScene>& scene, IntegratorState& state)
+  {
+    const Material* material = group[0].first;
+    ShadingPacket packet(directLightingBRDFTypes);
+    LightSample ls[ShadingPacket::maxSize];
+
+    for (size_t i=0; i<scene->allLights.size(); i++)
+    {
+      const Ref<Light>& light = scene->allLights[i];
+
+      /*! sample the light for all hit points, directions of lanes without light are never used */
+      packet.clear();
+      for (size_t j=0; j<N; j++)
+      {
+        PrimaryHit& hit = hits[group[j].second];
+        if ((light->illumMask & hit.dg.illumMask) == 0) ls[j].L = Color(zero);
+        else if (light->precompute()) ls[j] = hit.sample->getLightSample(precomputedLightSampleID[i]);
+        else ls[j].L = light->sample(hit.dg, ls[j].wi, ls[j].tMax, hit.sample->getVec2f(lightSampleID));
+        if (ls[j].L == Color(zero) || ls[j].wi.pdf == 0.0f) { ls[j].L = Color(zero); ls[j].wi = hit.dg.Ns; }
+        packet.add(hit.ray, hit.dg, ls[j].wi);
+      }
+
+      /*! evaluate the BRDFs of all hit points at once */
+      material->shade(packet);
+
+      for (size_t j=0; j<N; j++)
+      {
+        if (ls[j].L == Color(zero)) continue;
+        const Color brdf = packet.getL(j);
+        if (brdf == Color(zero)) continue;
+        PrimaryHit& hit = hits[group[j].second];
+        const DifferentialGeometry& dg = hit.dg;
+
+        /*! Visibility of delta lights may be known from the shadow cache. */
+        const bool cacheable = shadowCache && light->delta();
+        const int visibility = cacheable ? shadowCache->lookup(dg.P,i,dg.shadowMask) : int(ShadowCache::UNKNOWN);
+        if (visibility == ShadowCache::OCCLUDED) continue;
+
+        /*! Test for shadows. */
+        if (visibility == ShadowCache::UNKNOWN) 
+        {
+          Ray shadowRay(dg.P, ls[j].wi, dg.error*epsilon, ls[j].tMax-dg.error*epsilon, hit.ray.time, dg.shadowMask);
+          rtcOccluded(scene->scene,(RTCRay&)shadowRay);
+          state.numRays++;
+          if (cacheable) shadowCache->record(dg.P,i,dg.shadowMask,shadowRay);
+          if (shadowRay) continue;
+        }
+
+        hit.L += ls[j].L * brdf * rcp(ls[j].wi.pdf);
+      }
+    }
+  }
+}
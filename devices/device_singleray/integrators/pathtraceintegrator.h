@@ -18,6 +18,8 @@
 #define __EMBREE_PATH_TRACE_INTEGRATOR_H__
 
 #include "integrators/integrator.h"
+#include "integrators/shadowcache.h"
+#include "integrators/sdtree.h"
 #include "renderers/renderer.h"
 #include "image/image.h"
 
@@ -63,18 +65,63 @@ namespace embree
     /*! Registers samples we need tom the sampler. */
     void requestSamples(Ref<SamplerFactory>& samplerFactory, const Ref<BackendScene>& scene);
 
+    /*! Clears the shadow cache and guiding tree if the scene changed
+     *  and finishes training passes of the guiding tree. */
+    void prepare(const Ref<BackendScene>& scene);
+
     /*! Function that is recursively called to compute the path. */
     Color Li(LightPath& lightPath, const Ref<BackendScene>& scene, IntegratorState& state);
 
+    /*! Shades the hit point of the last ray of the path. If
+     *  deferDirectLighting is given, direct lighting is left to the
+     *  caller and the flag tells if the hit point needs it. */
+    Color shade(LightPath& lightPath, DifferentialGeometry& dg, const Ref<BackendScene>& scene, IntegratorState& state,
+                bool* deferDirectLighting = NULL);
+
     /*! Computes the radiance arriving at the origin of the ray from the ray direction. */
     Color Li(Ray& ray, const Ref<BackendScene>& scene, IntegratorState& state);
 
+    /*! Computes the radiance along an already intersected ray with known hit point. */
+    Color Li(Ray& ray, const DifferentialGeometry& dg, const Ref<BackendScene>& scene, IntegratorState& state);
+
+    /*! Computes the radiance of the primary rays of a tile. Direct
+     *  lighting of the first hits is computed in packets of hit
+     *  points that share a material. */
+    void Li(PrimaryHit* hits, size_t N, const Ref<BackendScene>& scene, IntegratorState& state);
+
+  private:
+
+    /*! Adds direct lighting to a group of at most ShadingPacket::maxSize
+     *  first hits of one material, evaluating the BRDFs in SIMD. */
+    void directLighting(PrimaryHit* hits, const std::pair<Material*,size_t>* group, size_t N, 
+                        const Ref<BackendScene>& scene, IntegratorState& state);
+
+    /*! Tests if the BRDF consists of diffuse reflection only, which is where paths get guided. */
+    bool guidable(const CompositedBRDF& brdfs) const;
+
+    /*! Samples a direction at a guidable surface, mixing guiding and
+     *  BRDF sampling through one-sample MIS. */
+    Color sampleGuided(const SDTree::Leaf* leaf, const CompositedBRDF& brdfs, const Vector3f& wo, 
+                       const DifferentialGeometry& dg, Sample3f& wi, const Vec2f& s, float ss) const;
+
     /* Configuration. */
   private:
     size_t maxDepth;               //!< Maximal recursion depth (1=primary ray only)
     float minContribution;         //!< Minimal contribution of a path to the pixel.
     float epsilon;                 //!< Epsilon to avoid self intersections.
     Ref<Image> backplate;          //!< High resolution background.
+    Ref<ShadowCache> shadowCache;  //!< Visibility cache for delta lights (optional).
+    Ref<BackendScene> cachedScene; //!< Scene the shadow cache and guiding tree are valid for.
+
+    /*! Path guiding. */
+  private:
+    bool guiding;                  //!< Enables path guiding.
+    float guidingFraction;         //!< Probability to sample the guiding distribution instead of the BRDF.
+    size_t guidingSpatialThreshold;//!< Samples per leaf in a one frame pass before the leaf is split.
+    float guidingDirectionalThreshold; //!< Energy fraction above which directional quadrants are split.
+    Ref<SDTree> guidingTree;       //!< Learned radiance distribution.
+    int guidingPassLength;         //!< Number of frames of the current training pass.
+    int guidingPassFrames;         //!< Number of frames rendered in the current training pass.
 
     /*! Random variables. */
   private:
@@ -0,0 +1,191 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "integrators/sdtree.h"
+
+namespace embree
+{
+  /*! Area preserving mapping of directions to the unit square. */
+  static __forceinline Vec2f directionToSquare(const Vector3f& d)
+  {
+    const float cosTheta = clamp(d.z,-1.0f,1.0f);
+    float phi = atan2f(d.y,d.x);
+    if (phi < 0.0f) phi += float(two_pi);
+    return Vec2f(clamp(0.5f*(cosTheta+1.0f),0.0f,1.0f),clamp(phi*float(one_over_two_pi),0.0f,1.0f));
+  }
+
+  /*! Inverse of the mapping of directions to the unit square. */
+  static __forceinline Vector3f squareToDirection(const Vec2f& p)
+  {
+    const float cosTheta = 2.0f*p.x-1.0f;
+    const float sinTheta = sqrt(max(0.0f,1.0f-cosTheta*cosTheta));
+    const float phi = p.y*float(two_pi);
+    return Vector3f(sinTheta*cosf(phi),sinTheta*sinf(phi),cosTheta);
+  }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// Directional Quadtree
+  ////////////////////////////////////////////////////////////////////////////////
+
+  void DTree::record(const Vector3f& wi, float energy)
+  {
+    Vec2f p = directionToSquare(wi);
+    for (int n=0;;)
+    {
+      const int qx = p.x >= 0.5f, qy = p.y >= 0.5f, q = qx+2*qy;
+      nodes[n].sum[q] += energy;
+      if (!nodes[n].child[q]) break;
+      p = Vec2f(2.0f*p.x-float(qx),2.0f*p.y-float(qy));
+      n = nodes[n].child[q];
+    }
+    samples++;
+  }
+
+  float DTree::pdf(const Vector3f& wi) const
+  {
+    Vec2f p = directionToSquare(wi);
+    float pdf = float(one_over_four_pi);
+    for (int n=0;;)
+    {
+      const int qx = p.x >= 0.5f, qy = p.y >= 0.5f, q = qx+2*qy;
+      const float total = nodes[n].total();
+      if (nodes[n].sum[q] <= 0.0f) return 0.0f;
+      pdf *= 4.0f*nodes[n].sum[q]*rcp(total);
+      if (!nodes[n].child[q]) break;
+      p = Vec2f(2.0f*p.x-float(qx),2.0f*p.y-float(qy));
+      n = nodes[n].child[q];
+    }
+    return pdf;
+  }
+
+  Sample3f DTree::sample(const Vec2f& s_in) const
+  {
+    if (energy() <= 0.0f) return Sample3f(zero,0.0f);
+
+    Vec2f s = s_in, origin(zero);
+    float size = 1.0f, pdf = float(one_over_four_pi);
+    for (int n=0;;)
+    {
+      const Node& node = nodes[n];
+      const float total = node.total();
+
+      /*! pick the column of the quadrant, then the row inside the column */
+      int qx = 0, qy = 0;
+      const float px = (node.sum[0]+node.sum[2])*rcp(total);
+      if (s.x < px) s.x = s.x*rcp(px); 
+      else { s.x = (s.x-px)*rcp(1.0f-px); qx = 1; }
+      const float py = node.sum[qx]*rcp(node.sum[qx]+node.sum[qx+2]);
+      if (s.y < py) s.y = s.y*rcp(py); 
+      else { s.y = (s.y-py)*rcp(1.0f-py); qy = 1; }
+      s = Vec2f(min(s.x,0.99999994f),min(s.y,0.99999994f));
+
+      const int q = qx+2*qy;
+      pdf *= 4.0f*node.sum[q]*rcp(total);
+      size *= 0.5f;
+      origin = origin + size*Vec2f(float(qx),float(qy));
+      if (!node.child[q]) break;
+      n = node.child[q];
+    }
+    return Sample3f(squareToDirection(origin+size*s),pdf);
+  }
+
+  void DTree::refine(const DTree& source, float threshold, int maxDepth)
+  {
+    nodes.clear();
+    nodes.push_back(Node());
+    samples = 0;
+    const float total = source.energy();
+    if (total > 0.0f) refine(source,0,total,0,1,threshold*total,maxDepth);
+  }
+
+  void DTree::refine(const DTree& source, int sourceNode, float sourceEnergy, int node, int depth, float minEnergy, int maxDepth)
+  {
+    for (int q=0; q<4; q++)
+    {
+      /*! quadrants the source did not subdivide spread their energy evenly */
+      const float e = sourceNode >= 0 ? source.nodes[sourceNode].sum[q] : 0.25f*sourceEnergy;
+      if (e <= minEnergy || depth >= maxDepth) continue;
+
+      const int child = (int)nodes.size();
+      nodes.push_back(Node());
+      nodes[node].child[q] = child;
+      const int sourceChild = sourceNode >= 0 && source.nodes[sourceNode].child[q] ? source.nodes[sourceNode].child[q] : -1;
+      refine(source,sourceChild,e,child,depth+1,minEnergy,maxDepth);
+    }
+  }
+
+  ////////////////////////////////////////////////////////////////////////////////
+  /// Spatial Tree
+  ////////////////////////////////////////////////////////////////////////////////
+
+  SDTree::SDTree (const BBox3f& bounds)
+    : bounds(bounds)
+  {
+    Node root; root.child[0] = -1; root.child[1] = 0; root.depth = 0;
+    nodes.push_back(root);
+    leaves.push_back(new Leaf);
+  }
+
+  SDTree::~SDTree () {
+    for (size_t i=0; i<leaves.size(); i++) delete leaves[i];
+  }
+
+  SDTree::Leaf* SDTree::lookup(const Vector3f& P) const
+  {
+    BBox3f box = bounds;
+    int n = 0;
+    while (nodes[n].child[0] >= 0) 
+    {
+      const int axis = nodes[n].depth%3;
+      const float mid = 0.5f*(box.lower[axis]+box.upper[axis]);
+      if (P[axis] < mid) { box.upper[axis] = mid; n = nodes[n].child[0]; }
+      else               { box.lower[axis] = mid; n = nodes[n].child[1]; }
+    }
+    return leaves[nodes[n].child[1]];
+  }
+
+  void SDTree::update(size_t maxSamples, float threshold, int maxDepth)
+  {
+    /*! split leaves that received many samples, the children again
+     *  test the halved sample count as the node array grows */
+    for (size_t n=0; n<nodes.size(); n++)
+    {
+      if (nodes[n].child[0] >= 0 || nodes[n].depth >= maxSpatialDepth) continue;
+      Leaf* leaf = leaves[nodes[n].child[1]];
+      if (leaf->building.samples <= maxSamples) continue;
+
+      Leaf* other = new Leaf;
+      other->sampling = leaf->sampling;
+      other->building = leaf->building;
+      other->building.samples = leaf->building.samples /= 2;
+
+      Node left;  left.child[0]  = -1; left.child[1]  = nodes[n].child[1];  left.depth  = nodes[n].depth+1;
+      Node right; right.child[0] = -1; right.child[1] = (int)leaves.size(); right.depth = nodes[n].depth+1;
+      leaves.push_back(other);
+      nodes[n].child[0] = (int)nodes.size();
+      nodes[n].child[1] = (int)nodes.size()+1;
+      nodes.push_back(left);
+      nodes.push_back(right);
+    }
+
+    /*! the recorded radiance becomes the sampling distribution and
+     *  the directional trees are refined for the next pass */
+    for (size_t i=0; i<leaves.size(); i++) {
+      leaves[i]->sampling = leaves[i]->building;
+      leaves[i]->building.refine(leaves[i]->sampling,threshold,maxDepth);
+    }
+  }
+}
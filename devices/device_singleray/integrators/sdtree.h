@@ -0,0 +1,130 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#ifndef __EMBREE_SD_TREE_H__
+#define __EMBREE_SD_TREE_H__
+
+#include "../default.h"
+#include "math/bbox.h"
+#include "sys/sync/mutex.h"
+#include <vector>
+
+namespace embree
+{
+  /*! Directional quadtree over the sphere of directions. Directions
+   *  are mapped area preserving to the unit square by their
+   *  cosine theta and phi, each node stores the energy that arrived
+   *  through its four quadrants. The tree can be sampled and the
+   *  sampling PDF be evaluated proportional to the stored energy. */
+  class DTree
+  {
+    struct Node
+    {
+      Node () { for (size_t i=0; i<4; i++) { sum[i] = 0.0f; child[i] = 0; } }
+
+      /*! Returns the summed energy of all quadrants. */
+      __forceinline float total() const { return sum[0]+sum[1]+sum[2]+sum[3]; }
+
+      float sum[4];   //!< Energy of each quadrant.
+      int child[4];   //!< Child node of each quadrant, 0 marks a leaf.
+    };
+
+  public:
+
+    /*! Creates a tree with a single node. */
+    DTree () : samples(0) { nodes.push_back(Node()); }
+
+    /*! Records energy arriving from a direction. */
+    void record(const Vector3f& wi, float energy);
+
+    /*! Evaluates the solid angle PDF of sampling a direction. */
+    float pdf(const Vector3f& wi) const;
+
+    /*! Samples a direction proportional to the stored energy. */
+    Sample3f sample(const Vec2f& s) const;
+
+    /*! Returns the total stored energy. */
+    __forceinline float energy() const { return nodes[0].total(); }
+
+    /*! Replaces the tree by an empty tree whose quadrants are
+     *  subdivided wherever the source tree stored more than the
+     *  given fraction of its energy. */
+    void refine(const DTree& source, float threshold, int maxDepth);
+
+  private:
+    void refine(const DTree& source, int sourceNode, float sourceEnergy, int node, int depth, float minEnergy, int maxDepth);
+
+  public:
+    size_t samples;            //!< Number of recorded samples.
+  private:
+    std::vector<Node> nodes;   //!< Nodes of the quadtree, the root comes first.
+  };
+
+  /*! Spatial-directional tree for path guiding. A binary tree
+   *  subdivides the scene bounds, alternating the split axis, and each
+   *  leaf stores one directional quadtree to sample from and one
+   *  that records the radiance of the current training pass. */
+  class SDTree : public RefCount
+  {
+    ALIGNED_CLASS
+  public:
+
+    /*! Directional distributions of a spatial leaf. */
+    struct Leaf
+    {
+      DTree sampling;          //!< Learned distribution used for sampling.
+      DTree building;          //!< Distribution recorded during the current pass.
+      MutexActive mutex;       //!< Protects recording into the building tree.
+    };
+
+    /*! Creates a tree covering the given bounds. */
+    SDTree (const BBox3f& bounds);
+
+    /*! Destruction. */
+    ~SDTree ();
+
+    /*! Returns the leaf containing a location. */
+    Leaf* lookup(const Vector3f& P) const;
+
+    /*! Records energy arriving at P from direction wi into the building tree of the leaf. */
+    __forceinline void record(Leaf* leaf, const Vector3f& wi, float energy) {
+      Lock<MutexActive> lock(leaf->mutex);
+      leaf->building.record(wi,energy);
+    }
+
+    /*! Finishes a training pass. Splits leaves that recorded more
+     *  than the given number of samples, makes the recorded
+     *  distributions the sampling distributions, and refines the
+     *  directional trees for the next pass. */
+    void update(size_t maxSamples, float threshold, int maxDepth);
+
+  private:
+    struct Node 
+    {
+      int child[2];            //!< Inner nodes: children, leafs: child[0] is -1 and child[1] the leaf.
+      int depth;               //!< Depth of the node, the split axis is depth%3.
+    };
+
+  private:
+    static const int maxSpatialDepth = 48;  //!< Guards against splitting at degenerate sample clusters.
+
+    BBox3f bounds;             //!< Bounds of the tree.
+    std::vector<Node> nodes;   //!< Nodes of the spatial tree, the root comes first.
+    std::vector<Leaf*> leaves; //!< Directional distributions of the leaves.
+  };
+}
+
+#endif
@@ -0,0 +1,127 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#ifndef __EMBREE_SHADOW_CACHE_H__
+#define __EMBREE_SHADOW_CACHE_H__
+
+#include "sys/platform.h"
+#include "sys/ref.h"
+#include "math/vec3.h"
+#include "../shapes/differentialgeometry.h"
+
+namespace embree
+{
+  /*! Caches the binary visibility of delta lights in a world space
+   *  grid. Each entry covers one grid cell, light, and shadow mask
+   *  and is packed into a single 64 bit word of a direct mapped hash
+   *  table, such that threads update it with one compare and
+   *  swap. A cell answers lookups only after a number of consistent
+   *  shadow tests, cells that observed both outcomes (shadow
+   *  boundaries) are marked mixed and always traced. The cache
+   *  assumes static geometry and lights and has to be cleared when
+   *  the scene changes. */
+  class ShadowCache : public RefCount
+  {
+    ALIGNED_CLASS
+  public:
+
+    /*! Cached visibility states. */
+    enum { UNKNOWN = 0, VISIBLE = 1, OCCLUDED = 2, MIXED = 3 };
+
+    /*! Creates a cache of 2^log2Entries entries. */
+    ShadowCache (float cellSize, int minObservations, size_t log2Entries = 20)
+      : rcpCellSize(rcp(cellSize)), minObservations(min(minObservations,255)), mask((size_t(1) << log2Entries)-1)
+    {
+      entries = (volatile int64*) alignedMalloc(sizeof(int64)*(mask+1),64);
+      clear();
+    }
+
+    ~ShadowCache () {
+      alignedFree((void*)entries);
+    }
+
+    /*! Forgets all cached visibility. */
+    void clear() {
+      for (size_t i=0; i<=mask; i++) entries[i] = 0;
+    }
+
+    /*! Returns VISIBLE or OCCLUDED if the visibility of the light
+     *  from P is known, and UNKNOWN if a shadow ray has to be traced. */
+    __forceinline int lookup(const Vector3f& P, size_t light, light_mask_t shadowMask) const
+    {
+      const int64 key = hash(P,light,shadowMask);
+      const int64 entry = entries[size_t(key) & mask];
+      if ((entry & TAG_BITS) != (key & TAG_BITS)) return UNKNOWN;
+      const int state = int(entry & STATE_BITS);
+      if (state == MIXED || int((entry & COUNT_BITS) >> 8) < minObservations) return UNKNOWN;
+      return state;
+    }
+
+    /*! Records the outcome of a traced shadow ray. */
+    __forceinline void record(const Vector3f& P, size_t light, light_mask_t shadowMask, bool occluded)
+    {
+      const int64 key = hash(P,light,shadowMask);
+      const int64 tag = key & TAG_BITS;
+      const int64 state = occluded ? OCCLUDED : VISIBLE;
+      volatile int64* entry = &entries[size_t(key) & mask];
+
+      while (true)
+      {
+        const int64 old = *entry;
+        int64 next;
+        if ((old & TAG_BITS) != tag) next = tag | (int64(1) << 8) | state;
+        else if ((old & STATE_BITS) == MIXED) return;
+        else if ((old & STATE_BITS) != state) next = tag | MIXED;
+        else {
+          const int64 count = (old & COUNT_BITS) >> 8;
+          if (count >= minObservations) return;
+          next = tag | ((count+1) << 8) | state;
+        }
+        if (atomic_cmpxchg(entry,next,old) == old) return;
+      }
+    }
+
+  private:
+
+    /*! Hashes grid cell, light, and shadow mask. The upper bits are
+     *  used as tag, the top bit is forced to distinguish tags from
+     *  empty entries. */
+    __forceinline int64 hash(const Vector3f& P, size_t light, light_mask_t shadowMask) const
+    {
+      uint64 h = uint64(int64(floorf(P.x*rcpCellSize)));
+      h = h*0x9E3779B97F4A7C15ull + uint64(int64(floorf(P.y*rcpCellSize)));
+      h = h*0x9E3779B97F4A7C15ull + uint64(int64(floorf(P.z*rcpCellSize)));
+      h = h*0x9E3779B97F4A7C15ull + uint64(light);
+      h = h*0x9E3779B97F4A7C15ull + uint64(uint32(shadowMask));
+      h ^= h >> 31; h *= 0xBF58476D1CE4E5B9ull;
+      h ^= h >> 27; h *= 0x94D049BB133111EBull;
+      h ^= h >> 31;
+      return int64(h | 0x8000000000000000ull);
+    }
+
+    static const int64 TAG_BITS   = ~int64(0xFFFF);
+    static const int64 COUNT_BITS = 0xFF00;
+    static const int64 STATE_BITS = 0x3;
+
+  private:
+    float rcpCellSize;          //!< Reciprocal edge length of a grid cell.
+    int minObservations;        //!< Number of consistent shadow tests before a cell answers lookups.
+    size_t mask;                //!< Mask to map hash values to entries.
+    volatile int64* entries;    //!< Tag, observation count, and state per entry.
+  };
+}
+
+#endif
@@ -45,6 +45,7 @@ namespace embree
       return new AmbientLight(L,illumMask,shadowMask);
     }
 
+    using EnvironmentLight::Le;
     Color Le(const Vector3f& wo) const {
       return L;
     }
@@ -53,6 +53,10 @@ namespace embree
       return zero;
     }
 
+    bool delta() const {
+      return true;
+    }
+
   private:
     Vector3f _wo;    //!< negative light direction
     Color E;      //!< Irradiance (W/m^2)
@@ -55,6 +55,7 @@ namespace embree
                               illumMask,shadowMask);
     }
 
+    using EnvironmentLight::Le;
     Color Le(const Vector3f& wo) const {
       if (dot(-wo,_wo) >= cosHalfAngle) return L;
       return zero;
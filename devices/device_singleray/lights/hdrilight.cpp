@@ -22,7 +22,7 @@ namespace embree
   HDRILight::HDRILight(const AffineSpace3f& local2world, 
                        unsigned width, unsigned height, 
                        const Color& L, const Ref<Image>& pixels, 
-                       const Ref<Distribution2D>& distribution,
+                       const Ref<AliasDistribution2D>& distribution,
                        light_mask_t illumMask,
                        light_mask_t shadowMask)
     : EnvironmentLight(illumMask,shadowMask), 
@@ -32,37 +32,49 @@ namespace embree
       height(height), 
       L(L), 
       pixels(pixels), 
+      texels(NULL),
       distribution(distribution) 
-  {}
+  {
+    if (const Image3f* img = dynamic_cast<const Image3f*>(pixels.ptr))
+      texels = (const Col3f*) img->ptr();
+  }
   
   HDRILight::HDRILight(const Parms& parms)
-    : width(0), height(0), pixels(null)
+    : width(0), height(0), pixels(null), texels(NULL)
   {
     local2world = parms.getTransform("local2world",one);
     world2local = rcp(local2world);
     L = parms.getColor("L",one);
+
     pixels = parms.getImage("image");
     if (pixels == null) pixels = new Image3f(5,5,one);
+
+    /*! RGB float images are read directly, other formats such as
+     *  compressed images keep their storage and go through Image::get */
+    if (const Image3f* img = dynamic_cast<const Image3f*>(pixels.ptr))
+      texels = (const Col3f*) img->ptr();
     width  = (unsigned) pixels->width;
     height = (unsigned) pixels->height;
 
     Array2D<float> importance(height,width);
     for (size_t y = 0; y < height; y++)
       for (size_t x = 0; x < width; x++)
-        importance.set(y, x, sinf(float(pi)*(y+0.5f)*rcp(float(height))) * reduce_add(pixels->get(x,y)));
+        importance.set(y, x, sinf(float(pi)*(y+0.5f)*rcp(float(height))) * reduce_add(texel(x,y)));
 
-    distribution = new Distribution2D(importance,width,height);
+    distribution = new AliasDistribution2D(importance,width,height);
   }
 
-  __forceinline Color HDRILight::Le(const Vector3f& wo) const
+  template<typename T>
+  __forceinline void HDRILight::toUV(const T& x, const T& y, const T& z, T& u, T& v)
   {
-    Vector3f wi = xfmVector(world2local, -wo);
-    float theta = acosf(clamp(wi.y,-1.0f,1.0f));
-    float phi = atan2f(-wi.z,-wi.x);
-    if (phi < 0) phi += 2.0f * float(pi);
-    float u = 1.0f - (phi * float(one_over_two_pi));
-    float v = theta * float(one_over_pi);
+    /*! u = 1-phi/(2*pi) with phi in [0,2*pi) */
+    u = fast_atan2(-z,-x) * T(-float(one_over_two_pi));
+    u = select(u < T(0.0f), u+T(1.0f), u);
+    v = fast_acos(min(max(y,T(-1.0f)),T(1.0f))) * T(float(one_over_pi));
+  }
 
+  __forceinline Color HDRILight::lookup(const float u, const float v) const
+  {
     ssize_t x = clamp(ssize_t(u*width), ssize_t(0), ssize_t(width-1));
     ssize_t xNext = x + 1;
     if (size_t(xNext) == width) xNext = 0;
@@ -73,10 +85,10 @@ namespace embree
     if (size_t(yNext) == height) yNext = height-1;
     float beta  = v*height - y;
 
-    Color c0 = pixels->get(x,     y    );
-    Color c1 = pixels->get(xNext, y    );
-    Color c2 = pixels->get(xNext, yNext);
-    Color c3 = pixels->get(x,     yNext);
+    Color c0 = texel(x,     y    );
+    Color c1 = texel(xNext, y    );
+    Color c2 = texel(xNext, yNext);
+    Color c3 = texel(x,     yNext);
 
     Color temp0 = beta*c3 + (1-beta)*c0;
     Color temp1 = beta*c2 + (1-beta)*c1;
@@ -84,30 +96,54 @@ namespace embree
     return L * (alpha*temp1 + (1-alpha)*temp0);
   }
 
+  __forceinline Color HDRILight::Le(const Vector3f& wo) const
+  {
+    Vector3f wi = xfmVector(world2local, -wo);
+    float u, v; toUV(wi.x,wi.y,wi.z,u,v);
+    return lookup(u,v);
+  }
+
+  void HDRILight::Le(const Vector3f* wo, Color* Ls, size_t N) const
+  {
+    /*! map four directions at once to image coordinates */
+    size_t i=0;
+    for (; i+3<N; i+=4)
+    {
+      const ssef ox(wo[i+0].x,wo[i+1].x,wo[i+2].x,wo[i+3].x);
+      const ssef oy(wo[i+0].y,wo[i+1].y,wo[i+2].y,wo[i+3].y);
+      const ssef oz(wo[i+0].z,wo[i+1].z,wo[i+2].z,wo[i+3].z);
+      const LinearSpace3f& l = world2local.l;
+      const ssef x = -(ssef(l.vx.x)*ox + ssef(l.vy.x)*oy + ssef(l.vz.x)*oz);
+      const ssef y = -(ssef(l.vx.y)*ox + ssef(l.vy.y)*oy + ssef(l.vz.y)*oz);
+      const ssef z = -(ssef(l.vx.z)*ox + ssef(l.vy.z)*oy + ssef(l.vz.z)*oz);
+      ssef u, v; toUV(x,y,z,u,v);
+      for (size_t j=0; j<4; j++) Ls[i+j] = lookup(u[j],v[j]);
+    }
+    for (; i<N; i++) Ls[i] = Le(wo[i]);
+  }
+
   Color HDRILight::eval(const DifferentialGeometry& dg, const Vector3f& wi) const {
     return Le(-wi);
   }
 
   Color HDRILight::sample(const DifferentialGeometry& dg, Sample3f& wi, float& tMax, const Vec2f& sample) const
   {
+    /*! with a = 2*pi*x/width-pi in [-pi,pi] the azimuth is phi = pi-a */
     Sample2f pixelF = distribution->sample(sample);
     float theta = float(pi) * pixelF.value.y*rcp(float(height));
-    float phi   = float(two_pi) * (1.0f - pixelF.value.x*rcp(float(width)));
-    Vector3f _wi = Vector3f(-sinf(theta)*cosf(phi),cosf(theta),-sinf(theta)*sinf(phi));
-    wi = Sample3f(xfmVector(local2world, _wi),pixelF.pdf*rcp(float(two_pi) * float(pi) * sinf(theta)));
+    float a     = float(two_pi) * pixelF.value.x*rcp(float(width)) - float(pi);
+    float sinTheta = fast_sin(theta), cosTheta = fast_cos(theta);
+    Vector3f _wi = Vector3f(sinTheta*fast_cos(a),cosTheta,-sinTheta*fast_sin(a));
+    wi = Sample3f(xfmVector(local2world, _wi),pixelF.pdf*rcp(float(two_pi) * float(pi) * sinTheta));
     tMax = inf;
-    return L*pixels->get(clamp(ssize_t(pixelF.value.x), ssize_t(0), ssize_t(width-1)),
-                         clamp(ssize_t(pixelF.value.y), ssize_t(0), ssize_t(height-1)));
+    return L*texel(clamp(ssize_t(pixelF.value.x), ssize_t(0), ssize_t(width-1)),
+                   clamp(ssize_t(pixelF.value.y), ssize_t(0), ssize_t(height-1)));
   }
 
   float HDRILight::pdf(const DifferentialGeometry& dg, const Vector3f& _wi) const {
     Vector3f wi = xfmVector(world2local, _wi);
-    float theta = acosf(wi.y);
-    float phi = atan2f(-wi.z,-wi.x);
-    if (phi < 0) phi += 2.0f * float(pi);
-    float u = 1.0f - float(one_over_two_pi) * phi;
-    float v = float(one_over_pi) * theta;
-    return distribution->pdf(Vec2f(u,v))*rcp(float(two_pi) * float(pi) * sinf(theta));
+    float u, v; toUV(wi.x,wi.y,wi.z,u,v);
+    float sinTheta = sqrt(max(1.0f-wi.y*wi.y,0.0f));
+    return distribution->pdf(Vec2f(u,v))*rcp(float(two_pi) * float(pi) * sinTheta);
   }
 }
-
@@ -31,7 +31,7 @@ namespace embree
     HDRILight(const AffineSpace3f& local2world, 
               unsigned width, unsigned height, 
               const Color& L, const Ref<Image>& pixels, 
-              const Ref<Distribution2D>& distribution,
+              const Ref<AliasDistribution2D>& distribution,
               light_mask_t illumMask=-1,
               light_mask_t shadowMask=-1);
   public:
@@ -47,12 +47,27 @@ namespace embree
     }
 
     Color Le    (const Vector3f& wo) const;
+    void  Le    (const Vector3f* wo, Color* Ls, size_t N) const;
     Color eval  (const DifferentialGeometry& dg, const Vector3f& wi) const;
     Color sample(const DifferentialGeometry& dg, Sample3f& wi, 
                  float& tMax, const Vec2f& s) const;
     float pdf   (const DifferentialGeometry& dg, const Vector3f& wi) const;
     bool  precompute() const { return true; }
 
+  private:
+
+    /*! Maps a direction in light space to image coordinates in [0,1]. */
+    template<typename T> static __forceinline void toUV(const T& x, const T& y, const T& z, T& u, T& v);
+
+    /*! Bilinear lookup of the environment at image coordinates u,v in [0,1]. */
+    __forceinline Color lookup(const float u, const float v) const;
+
+    /*! Returns the texel at integer coordinates x,y. */
+    __forceinline Color texel(const size_t x, const size_t y) const {
+      if (texels) { const Col3f& c = texels[y*width+x]; return Color(c.r,c.g,c.b); }
+      const Color4 c = pixels->get(x,y); return Color(c.r,c.g,c.b);
+    }
+
   protected:
     AffineSpace3f local2world;            //!< Transformation from light space into world space
     AffineSpace3f world2local;            //!< Transformation from world space into light space
@@ -60,7 +75,8 @@ namespace embree
     Color L;                            //!< Scaling factor for the image.
 
     Ref<Image> pixels;                  //!< The image mapped to the environment.
-    Ref<Distribution2D> distribution;   //!< The 2D distribution used to importance sample the image.
+    const Col3f* texels;                //!< Texels of RGB float images for direct lookups, NULL otherwise.
+    Ref<AliasDistribution2D> distribution; //!< The 2D distribution used to importance sample the image.
   };
 }
 
@@ -71,6 +71,11 @@ namespace embree
      *  integrator should presample the light. */
     virtual bool precompute() const { return false; }
 
+    /*! Indicates that the light is a delta light whose sample does
+     *  not depend on the sample location. The visibility of the light
+     *  from a point is thus deterministic and can be cached. */
+    virtual bool delta() const { return false; }
+
     light_mask_t illumMask;
     light_mask_t shadowMask;
   };
@@ -104,6 +109,11 @@ namespace embree
     {}
     /*! Returns the emitted radiance of the environment light. */
     virtual Color Le(const Vector3f& wo                     /*!< The direction the light comes from. */) const { return zero; }
+
+    /*! Returns the emitted radiance of the environment light for N directions at once. */
+    virtual void Le(const Vector3f* wo, Color* L, size_t N) const { 
+      for (size_t i=0; i<N; i++) L[i] = Le(wo[i]); 
+    }
   };
 }
 
@@ -0,0 +1,114 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "lights/meshlight.h"
+#include "samplers/shapesampler.h"
+
+namespace embree
+{
+  MeshLight::MeshLight (const Ref<TriangleMeshFull>& mesh, const Color& L, light_mask_t illumMask, light_mask_t shadowMask)
+    : AreaLight(illumMask,shadowMask), L(L), mesh(mesh), accel(NULL)
+  {
+    init();
+  }
+
+  MeshLight::MeshLight (const Parms& parms)
+    : accel(NULL)
+  {
+    L = parms.getColor("L");
+    mesh = new TriangleMeshFull(AccelType(parms));
+
+    if (Variant v = parms.getData("positions")) {
+      if (!v.data || v.type != Variant::FLOAT3) throw std::runtime_error("wrong position format");
+      mesh->position.resize(v.data->size());
+      for (size_t i=0; i<v.data->size(); i++) mesh->position[i] = v.data->getVector3f(i);
+    }
+    if (Variant v = parms.getData("indices")) {
+      if (!v.data || v.type != Variant::INT3) throw std::runtime_error("wrong triangle format");
+      mesh->triangles.resize(v.data->size());
+      for (size_t i=0; i<v.data->size(); i++) mesh->triangles[i] = v.data->getVector3i(i);
+    }
+    if (mesh->triangles.size() == 0) throw std::runtime_error("mesh light without triangles");
+    init();
+  }
+
+  MeshLight::~MeshLight () {
+    if (accel) rtcDeleteScene(accel);
+  }
+
+  void MeshLight::init()
+  {
+    /*! the radiance is constant over the mesh, thus the power of each
+     *  triangle is proportional to its area */
+    const size_t numTriangles = mesh->triangles.size();
+    Ng.resize(numTriangles);
+    float* power = new float[numTriangles];
+    float area = 0.0f;
+    for (size_t i=0; i<numTriangles; i++) {
+      const TriangleMeshFull::Triangle& tri = mesh->triangles[i];
+      const Vector3f v0 = mesh->position[tri.v0], v1 = mesh->position[tri.v1], v2 = mesh->position[tri.v2];
+      Ng[i] = cross(v0-v1,v2-v0);
+      power[i] = 0.5f*length(Ng[i]);
+      area += power[i];
+    }
+    distribution.init(power,numTriangles);
+    pdfArea = area > 0.0f ? rcp(area) : 0.0f;
+    delete[] power;
+
+    accel = rtcNewScene(RTC_SCENE_STATIC,RTC_INTERSECT1);
+    mesh->extract(accel,0);
+    rtcCommit(accel);
+  }
+
+  ssize_t MeshLight::intersect(const Vector3f& O, const Vector3f& D, float& t) const
+  {
+    Ray ray(O,D);
+    rtcIntersect(accel,(RTCRay&)ray);
+    if (!ray) return -1;
+    t = ray.tfar;
+    return ray.id1;
+  }
+
+  Color MeshLight::eval(const DifferentialGeometry& dg, const Vector3f& wi) const
+  {
+    float t; ssize_t i = intersect(dg.P,wi,t);
+    if (i < 0 || dot(wi,Ng[i]) >= 0.0f) return zero;
+    return L;
+  }
+
+  Color MeshLight::sample(const DifferentialGeometry& dg, Sample3f& wi, float& tMax, const Vec2f& s) const
+  {
+    /*! pick a triangle and reuse the fraction of the sample to place the point on it */
+    const DistributionSample st = distribution.sampleElement(s.x);
+    const size_t i = st.index;
+    const float u = st.fraction;
+
+    const TriangleMeshFull::Triangle& tri = mesh->triangles[i];
+    Vector3f d = uniformSampleTriangle(u,s.y,mesh->position[tri.v0],mesh->position[tri.v1],mesh->position[tri.v2])-dg.P;
+    tMax = length(d);
+    float dDotNg = dot(d,Ng[i]);
+    if (dDotNg >= 0) return zero;
+    wi = Sample3f(d*rcp(tMax),pdfArea*tMax*tMax*tMax*length(Ng[i])*rcp(fabs(dDotNg)));
+    return L;
+  }
+
+  float MeshLight::pdf(const DifferentialGeometry& dg, const Vector3f& wi) const
+  {
+    float t; ssize_t i = intersect(dg.P,wi,t);
+    if (i < 0) return zero;
+    return pdfArea*t*t*length(Ng[i])*rcp(abs(dot(wi,Ng[i])));
+  }
+}
@@ -0,0 +1,85 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#ifndef __EMBREE_MESH_LIGHT_H__
+#define __EMBREE_MESH_LIGHT_H__
+
+#include "../lights/light.h"
+#include "../shapes/trianglemesh_full.h"
+#include "../samplers/aliasdistribution1d.h"
+
+namespace embree
+{
+  /*! Implements an area light of constant radiance that covers a
+   *  whole triangle mesh. Triangles are picked proportional to their
+   *  emitted power, thus a single light sample and shadow ray is
+   *  taken per mesh independent of its number of triangles. */
+  class MeshLight : public AreaLight
+  {
+  protected:
+
+    /*! Construction from triangle mesh and radiance. */
+    MeshLight (const Ref<TriangleMeshFull>& mesh, const Color& L,
+               light_mask_t illumMask=-1,
+               light_mask_t shadowMask=-1);
+
+  public:
+
+    /*! Construction from parameter container. */
+    MeshLight (const Parms& parms);
+
+    /*! Destruction. */
+    ~MeshLight ();
+
+    Ref<Light> transform(const AffineSpace3f& xfm,
+                         light_mask_t illumMask,
+                         light_mask_t shadowMask) const {
+      return new MeshLight(mesh->transform(xfm).cast<TriangleMeshFull>(),L,illumMask,shadowMask);
+    }
+
+    /*! Returns the shape of the mesh light. */
+    Ref<Shape> shape() { return mesh.cast<Shape>(); }
+
+    Color Le(const DifferentialGeometry& dg, const Vector3f& wo) const {
+      return L;
+    }
+
+    Color eval  (const DifferentialGeometry& dg, const Vector3f& wi) const;
+    Color sample(const DifferentialGeometry& dg, Sample3f& wi, float& tMax, const Vec2f& s) const;
+    float pdf   (const DifferentialGeometry& dg, const Vector3f& wi) const;
+
+  private:
+
+    /*! Builds the power distribution over the triangles and the
+     *  acceleration structure of the mesh. */
+    void init();
+
+    /*! Finds the closest triangle hit by a ray of origin O and
+     *  direction D using the acceleration structure of the
+     *  mesh. \returns the index of the triangle or -1 */
+    ssize_t intersect(const Vector3f& O, const Vector3f& D, float& t) const;
+
+  private:
+    Color L;                       //!< Radiance (W/(m^2*sr))
+    Ref<TriangleMeshFull> mesh;    //!< Emitting triangle mesh
+    vector_t<Vector3f> Ng;         //!< Unnormalized normal of each triangle, length is twice the area
+    AliasDistribution1D distribution; //!< Distribution to pick triangles by emitted power
+    RTCScene accel;                //!< Acceleration structure over the triangles of the mesh
+    float pdfArea;                 //!< Probability density per unit area of the mesh
+  };
+}
+
+#endif
@@ -58,6 +58,10 @@ namespace embree
     float pdf(const DifferentialGeometry& dg, const Vector3f& wi) const {
       return zero;
     }
+
+    bool delta() const {
+      return true;
+    }
     
   private:
     Vector3f P;       //!< Position of the point light
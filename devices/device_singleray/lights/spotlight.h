@@ -71,6 +71,10 @@ namespace embree
       return zero;
     }
 
+    bool delta() const {
+      return true;
+    }
+
   private:
     Vector3f P;                        //!< Position of the spot light
     Vector3f _D;                       //!< Negative light direction of the spot light
@@ -21,6 +21,7 @@
 #include "../shapes/differentialgeometry.h"
 #include "../materials/medium.h"
 #include "../brdfs/compositedbrdf.h"
+#include "../materials/shadingpacket.h"
 
 namespace embree
 {
@@ -45,6 +46,18 @@ namespace embree
                        const DifferentialGeometry& dg,               /*!< The point to shade on a surface. */
                        CompositedBRDF&             brdfs)            /*!< Container for generated BRDF components. */ const = 0;
 
+    /*! Shades a packet of hit points of this material and accumulates
+     *  the BRDFs evaluated for the directions of the packet. The
+     *  default implementation shades each hit point individually. */
+    virtual void shade(ShadingPacket& packet) const
+    {
+      for (size_t i=0; i<packet.size(); i++) {
+        CompositedBRDF brdfs;
+        shade(*packet.rays[i], packet.medium, *packet.dgs[i], brdfs);
+        packet.addL(i, brdfs.eval(packet.getWo(i), *packet.dgs[i], packet.getWi(i), packet.types));
+      }
+    }
+
     /*! Tracks the medium when crossing the surface. */
     __forceinline Medium nextMedium(const Medium& current) {
       if (!isMediaInterface) return current;
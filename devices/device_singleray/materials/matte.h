@@ -36,6 +36,10 @@ namespace embree
       brdfs.add(NEW_BRDF(Lambertian)(reflectance));
     }
 
+    void shade(ShadingPacket& packet) const {
+      packet.eval(Lambertian(reflectance));
+    }
+
   protected:
 
     /*! Diffuse reflectance of the surface. The range is from 0
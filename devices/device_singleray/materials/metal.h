@@ -51,6 +51,14 @@ namespace embree
         brdfs.add(NEW_BRDF(MicrofacetMetal)(reflectance, FresnelConductor(eta,k), PowerCosineDistribution(rcpRoughness,dg.Ns)));
     }
 
+    void shade(ShadingPacket& packet) const
+    {
+      /*! the specular conductor evaluates to zero, the distribution
+       *  takes its direction from the normals of the packet */
+      if (roughness != 0.0f)
+        packet.eval(MicrofacetMetal(reflectance, FresnelConductor(eta,k), PowerCosineDistribution(rcpRoughness,Vector3f(0,0,1))));
+    }
+
   protected:
     Color reflectance; //!< Reflectivity of the metal
     Color eta;         //!< Real part of refraction index
@@ -71,6 +71,21 @@ namespace embree
       }
     }
 
+    void shade(ShadingPacket& packet) const
+    {
+      /*! the dielectric reflection evaluates to zero */
+      packet.eval(*paint);
+
+      if (glitterSpread != 0 && glitterColor != Color(zero)) 
+      {
+        Color etaAluminium(0.62f,0.62f,0.62f);
+        Color kAluminium(4.8,4.8,4.8);
+        packet.eval(DielectricLayer<MicrofacetGlitter>(one, 1.0f, eta, MicrofacetGlitter(glitterColor,
+                                                                                          FresnelConductor(etaAluminium,kAluminium),
+                                                                                          PowerCosineDistribution(rcp(glitterSpread),Vector3f(0,0,1)))));
+      }
+    }
+
   protected:
     Color glitterColor;
     float glitterSpread;
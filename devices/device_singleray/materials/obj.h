@@ -50,22 +50,35 @@ namespace embree {
         void shade(const Ray &ray, const Medium &currentMedium, const DifferentialGeometry &dg, CompositedBRDF &brdfs) const 
         {
           if (this->map_Bump) {
-            const Color bump = map_Bump->get(dg.st);
+            const Color bump = map_Bump->get(dg.st,dg.dstdx,dg.dstdy);
             const Vector3f b(2.0f*bump.r-1.0f,2.0f*bump.g-1.0f,2.0f*bump.b-1.0f);
             dg.Ns = normalize(b.x*dg.Tx + b.y*dg.Ty + b.z*dg.Ns);
           }
 
           /*! transmission */
-          float d = this->d;  if (map_d) d *= map_d->get(dg.st).r; if (d < 1.0f) brdfs.add(NEW_BRDF(Transmission)(Color(1.0f - d)));
+          float d = this->d;  if (map_d) d *= map_d->get(dg.st,dg.dstdx,dg.dstdy).r; if (d < 1.0f) brdfs.add(NEW_BRDF(Transmission)(Color(1.0f - d)));
           
           /*! diffuse component */
-          Color Kd = d*this->Kd;  if (map_Kd) Kd *= map_Kd->get(dg.st);  if (Kd != Color(zero)) brdfs.add(NEW_BRDF(Lambertian)(Kd));
+          Color Kd = d*this->Kd;  if (map_Kd) Kd *= map_Kd->get(dg.st,dg.dstdx,dg.dstdy);  if (Kd != Color(zero)) brdfs.add(NEW_BRDF(Lambertian)(Kd));
           
           /*! specular exponent */
-          float Ns = this->Ns;  if (map_Ns) Ns *= map_Ns->get(dg.st).r;
+          float Ns = this->Ns;  if (map_Ns) Ns *= map_Ns->get(dg.st,dg.dstdx,dg.dstdy).r;
           
           /*! specular component */
-          Color Ks = d*this->Ks;  if (map_Ks) Ks *= map_Ks->get(dg.st);  if (Ks != Color(zero)) brdfs.add(NEW_BRDF(Specular)(Ks, Ns));
+          Color Ks = d*this->Ks;  if (map_Ks) Ks *= map_Ks->get(dg.st,dg.dstdx,dg.dstdy);  if (Ks != Color(zero)) brdfs.add(NEW_BRDF(Specular)(Ks, Ns));
+        }
+
+        void shade(ShadingPacket &packet) const
+        {
+          /*! textured parameters vary per hit point */
+          if (map_d || map_Kd || map_Ks || map_Ns || map_Bump) {
+            Material::shade(packet);
+            return;
+          }
+
+          /*! the transmission component evaluates to zero */
+          Color Kd = d*this->Kd;  if (Kd != Color(zero)) packet.eval(Lambertian(Kd));
+          Color Ks = d*this->Ks;  if (Ks != Color(zero)) packet.eval(Specular(Ks, Ns));
         }
 
     protected:
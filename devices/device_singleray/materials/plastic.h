@@ -57,6 +57,16 @@ namespace embree
         brdfs.add(NEW_BRDF(MicrofacetPlastic)(one, FresnelDielectric(1.0f, eta), PowerCosineDistribution(rcpRoughness,dg.Ns)));
     }
 
+    void shade(ShadingPacket& packet) const
+    {
+      packet.eval(DielectricLayer<Lambertian >(one, 1.0f, eta, Lambertian (pigmentColor)));
+
+      /*! the dielectric reflection evaluates to zero, the distribution
+       *  takes its direction from the normals of the packet */
+      if (roughness != 0.0f)
+        packet.eval(MicrofacetPlastic(one, FresnelDielectric(1.0f, eta), PowerCosineDistribution(rcpRoughness,Vector3f(0,0,1))));
+    }
+
   protected:
     Color pigmentColor; //!< Color of the diffuse layer.
     float eta;          //!< Refraction index of the dielectric layer.
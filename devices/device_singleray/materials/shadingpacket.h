@@ -0,0 +1,124 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#ifndef __EMBREE_SHADING_PACKET_H__
+#define __EMBREE_SHADING_PACKET_H__
+
+#include "renderers/ray.h"
+#include "../shapes/differentialgeometry.h"
+#include "../materials/medium.h"
+#include "../brdfs/brdf.h"
+
+namespace embree
+{
+  /*! Packet of hit points that share a material. Directions and
+   *  normals are stored in SoA layout, such that the material can
+   *  evaluate its BRDFs for many hit points at once using SIMD. The
+   *  BRDFs are evaluated for the incoming direction wi given per hit
+   *  point and accumulated into the radiance L. Only BRDF components
+   *  of the types selected for the packet are evaluated. */
+  class ShadingPacket
+  {
+    ALIGNED_CLASS
+  public:
+
+    /*! SIMD type used for shading */
+#if defined(__AVX__)
+    typedef avxf simdf;
+#else
+    typedef ssef simdf;
+#endif
+
+    /*! maximal number of hit points per packet */
+    enum { maxSize = 256 };
+
+    /*! Constructs an empty packet that evaluates BRDF components of
+     *  the given types, for hit points seen from the given medium. */
+    __forceinline ShadingPacket (const BRDFType types = ALL, const Medium& medium = Medium::Vacuum()) 
+      : types(types), medium(medium), num(0) {}
+
+    /*! Returns the number of hit points in the packet. */
+    __forceinline size_t size() const { return num; }
+
+    /*! Removes all hit points from the packet. */
+    __forceinline void clear() { num = 0; }
+
+    /*! Adds a hit point. The differential geometry has to stay valid
+     *  while the packet is shaded. */
+    __forceinline void add(const Ray& ray, const DifferentialGeometry& dg, const Vector3f& dir)
+    {
+      assert(num < maxSize);
+      rays[num] = &ray; dgs[num] = &dg;
+      set(wo,num,-ray.dir); set(Ng,num,dg.Ng); set(Ns,num,dg.Ns); set(wi,num,dir);
+      set(L,num,Vector3f(zero));
+      num++;
+    }
+
+    /*! Returns the outgoing and incoming direction of the i'th hit point. */
+    __forceinline Vector3f getWo(size_t i) const { return get(wo,i); }
+    __forceinline Vector3f getWi(size_t i) const { return get(wi,i); }
+
+    /*! Returns the radiance accumulated for the i'th hit point. */
+    __forceinline Color getL(size_t i) const { return Color(L[0][i],L[1][i],L[2][i]); }
+
+    /*! Accumulates radiance for the i'th hit point. */
+    __forceinline void addL(size_t i, const Color& c) { L[0][i] += c.r; L[1][i] += c.g; L[2][i] += c.b; }
+
+    /*! Evaluates a BRDF for all hit points using SIMD and
+     *  accumulates the result. The BRDF has to provide a templated
+     *  eval function for SIMD packets. */
+    template<typename B> __forceinline void eval(const B& brdf)
+    {
+      if ((brdf.type & types) == NONE) return;
+
+      /*! pad the arrays to the SIMD width by repeating the last hit point */
+      const size_t padded = (num+simdf::size-1)&size_t(-simdf::size);
+      for (size_t i=num; i<padded; i++) {
+        set(wo,i,get(wo,num-1)); set(Ng,i,get(Ng,num-1)); set(Ns,i,get(Ns,num-1)); set(wi,i,get(wi,num-1));
+      }
+
+      for (size_t i=0; i<padded; i+=simdf::size) {
+        const Vec3<simdf> c = brdf.eval(load(wo,i),load(Ng,i),load(Ns,i),load(wi,i));
+        *(simdf*)&L[0][i] += c.x;
+        *(simdf*)&L[1][i] += c.y;
+        *(simdf*)&L[2][i] += c.z;
+      }
+    }
+
+  private:
+    __forceinline void set(float v[3][maxSize], size_t i, const Vector3f& a) { v[0][i] = a.x; v[1][i] = a.y; v[2][i] = a.z; }
+    __forceinline Vector3f get(const float v[3][maxSize], size_t i) const { return Vector3f(v[0][i],v[1][i],v[2][i]); }
+    __forceinline Vec3<simdf> load(const float v[3][maxSize], size_t i) const {
+      return Vec3<simdf>(*(const simdf*)&v[0][i],*(const simdf*)&v[1][i],*(const simdf*)&v[2][i]);
+    }
+
+  private:
+    __align(64) float wo[3][maxSize];  //!< outgoing directions
+    __align(64) float Ng[3][maxSize];  //!< geometry normals
+    __align(64) float Ns[3][maxSize];  //!< shading normals
+    __align(64) float wi[3][maxSize];  //!< incoming directions to evaluate the BRDFs for
+    __align(64) float L [3][maxSize];  //!< accumulated radiance
+    size_t num;                        //!< number of hit points
+
+  public:
+    BRDFType types;                            //!< BRDF component types to evaluate
+    Medium medium;                             //!< medium the rays travel in
+    const Ray* rays[maxSize];                  //!< rays that hit the points
+    const DifferentialGeometry* dgs[maxSize];  //!< hit points for shading without SIMD
+  };
+}
+
+#endif
@@ -27,12 +27,18 @@ namespace embree
 
   void DebugRenderer::renderFrame(const Ref<Camera>& camera, const Ref<BackendScene>& scene, const Ref<ToneMapper>& toneMapper, Ref<SwapChain > swapchain, int accumulate) 
   {
-    new RenderJob(this,camera,scene,toneMapper,swapchain,accumulate);
+    new RenderJob(this,camera,scene,toneMapper,swapchain,accumulate,NULL,false);
+  }
+
+  void DebugRenderer::renderFrameAsync(const Ref<Camera>& camera, const Ref<BackendScene>& scene, const Ref<ToneMapper>& toneMapper, Ref<SwapChain > swapchain, int accumulate, volatile int* cancel) 
+  {
+    new RenderJob(this,camera,scene,toneMapper,swapchain,accumulate,cancel,true);
   }
   
   DebugRenderer::RenderJob::RenderJob (Ref<DebugRenderer> renderer, const Ref<Camera>& camera, const Ref<BackendScene>& scene, 
-                                       const Ref<ToneMapper>& toneMapper, Ref<SwapChain > swapchain, int accumulate)
-    : renderer(renderer), camera(camera), scene(scene), toneMapper(toneMapper), swapchain(swapchain), accumulate(accumulate)
+                                       const Ref<ToneMapper>& toneMapper, Ref<SwapChain > swapchain, int accumulate,
+                                       volatile int* cancel, bool async)
+    : renderer(renderer), camera(camera), scene(scene), toneMapper(toneMapper), swapchain(swapchain), accumulate(accumulate), cancel(cancel)
   {
     this->tileID = 0;
     this->atomicNumRays = 0;
@@ -43,15 +49,16 @@ namespace embree
     this->framebuffer = swapchain->buffer();
     this->framebuffer->startRendering(numTilesX*numTilesY);
 
-#if 1
-    TaskScheduler::EventSync event;
-    TaskScheduler::Task task(&event,_renderTile,this,TaskScheduler::getNumThreads(),_finish,this,"render::tile");
-    TaskScheduler::addTask(-1,TaskScheduler::GLOBAL_BACK,&task);
-    event.sync();
-#else
-    new (&task) TaskScheduler::Task (NULL,_renderTile,this,TaskScheduler::getNumThreads(),_finish,this,"render::tile");
-    TaskScheduler::addTask(-1,TaskScheduler::GLOBAL_BACK,&task);
-#endif
+    if (!async) {
+      TaskScheduler::EventSync event;
+      TaskScheduler::Task task(&event,_renderTile,this,TaskScheduler::getNumThreads(),_finish,this,"render::tile");
+      TaskScheduler::addTask(-1,TaskScheduler::GLOBAL_BACK,&task);
+      event.sync();
+    }
+    else {
+      new (&task) TaskScheduler::Task (NULL,_renderTile,this,TaskScheduler::getNumThreads(),_finish,this,"render::tile");
+      TaskScheduler::addTask(-1,TaskScheduler::GLOBAL_BACK,&task);
+    }
   }
 
   void DebugRenderer::RenderJob::finish(size_t threadIndex, size_t threadCount, TaskScheduler::Event* event)
@@ -75,6 +82,12 @@ namespace embree
       size_t tile = tileID++;
       if (tile >= numTilesX*numTilesY) break;
 
+      /*! skip the remaining tiles of a cancelled frame */
+      if (cancel && *cancel) {
+        framebuffer->finishTile();
+        continue;
+      }
+
       /*! compute tile location */
       Random rand(int(tile)*1024);
       size_t x0 = (tile%numTilesX)*TILE_SIZE;
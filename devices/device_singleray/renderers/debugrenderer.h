@@ -35,13 +35,17 @@ namespace embree
     /*! Renders a single frame. */
     void renderFrame(const Ref<Camera>& camera, const Ref<BackendScene>& scene, const Ref<ToneMapper>& toneMapper, Ref<SwapChain > film, int accumulate);
 
+    /*! Starts rendering a frame and returns immediately. */
+    void renderFrameAsync(const Ref<Camera>& camera, const Ref<BackendScene>& scene, const Ref<ToneMapper>& toneMapper, Ref<SwapChain > film, int accumulate, volatile int* cancel);
+
   private:
 
     class RenderJob
     {
     public:
       RenderJob (Ref<DebugRenderer> renderer, const Ref<Camera>& camera, const Ref<BackendScene>& scene, 
-                 const Ref<ToneMapper>& toneMapper, Ref<SwapChain > swapchain, int accumulate);
+                 const Ref<ToneMapper>& toneMapper, Ref<SwapChain > swapchain, int accumulate,
+                 volatile int* cancel, bool async);
        
     private:
 
@@ -60,6 +64,7 @@ namespace embree
       Ref<FrameBuffer> framebuffer;  //!< Framebuffer to render into
       Ref<SwapChain > swapchain;   //!< Swapchain to render into
       int accumulate;                //!< Accumulation mode
+      volatile int* cancel;          //!< Skips the remaining tiles when nonzero (optional)
 
       /*! Precomputations. */
     private:
@@ -0,0 +1,101 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#ifndef __EMBREE_FIRST_HIT_CACHE_H__
+#define __EMBREE_FIRST_HIT_CACHE_H__
+
+#include "../renderers/ray.h"
+#include "../api/scene.h"
+#include "../api/swapchain.h"
+
+namespace embree
+{
+  /*! Caches the intersected primary rays and their hit points for a
+   *  fixed number of primary samples per pixel. While the camera and
+   *  scene do not change, accumulation iterations cycle through the
+   *  cached samples instead of tracing primary rays again. The cache
+   *  needs about samplesPerPixel*sizeof(Entry) bytes per pixel, which
+   *  stay allocated when the entries get invalidated. */
+  class FirstHitCache : public RefCount
+  {
+    ALIGNED_CLASS
+  public:
+
+    /*! A cached primary sample. */
+    struct Entry
+    {
+      Ray ray;                    //!< Intersected primary ray.
+      DifferentialGeometry dg;    //!< Hit point of the ray.
+      Vec2f pixel;                //!< Normalized pixel location on screen.
+      unsigned stamp;             //!< Stamp of the cache when the entry got filled, 0 if never filled.
+    };
+
+    /*! Creates an empty cache for a swapchain and scene. */
+    FirstHitCache (const Ref<SwapChain>& swapchain, const Ref<BackendScene>& scene, size_t samplesPerPixel)
+      : swapchain(swapchain), scene(scene), width(swapchain->getWidth()), height(swapchain->getHeight()), samplesPerPixel(samplesPerPixel), stamp(1)
+    {
+      const size_t size = width*height*samplesPerPixel;
+      entries = (Entry*) alignedMalloc(size*sizeof(Entry),64);
+      for (size_t i=0; i<size; i++) entries[i].stamp = 0;
+    }
+
+    ~FirstHitCache () {
+      alignedFree(entries);
+    }
+
+    /*! Tests if the cache was created for a swapchain and scene. */
+    __forceinline bool matches(const Ref<SwapChain>& swapchain, const Ref<BackendScene>& scene) const {
+      return this->swapchain == swapchain && this->scene == scene && width == swapchain->getWidth() && height == swapchain->getHeight();
+    }
+
+    /*! Returns the entry of a primary sample of a pixel. */
+    __forceinline Entry& get(size_t x, size_t y, size_t sample) {
+      return entries[(y*width+x)*samplesPerPixel+sample];
+    }
+
+    /*! Tests if an entry got filled since the last invalidation. */
+    __forceinline bool valid(const Entry& entry) const {
+      return entry.stamp == stamp;
+    }
+
+    /*! Marks an entry as filled. */
+    __forceinline void validate(Entry& entry) const {
+      entry.stamp = stamp;
+    }
+
+    /*! Invalidates all entries without touching them. */
+    void invalidate() 
+    {
+      /*! reset the stamps of all entries when the stamp wraps around */
+      if (++stamp == 0) {
+        for (size_t i=0; i<width*height*samplesPerPixel; i++) entries[i].stamp = 0;
+        stamp = 1;
+      }
+    }
+
+  public:
+    Ref<SwapChain> swapchain;     //!< Swapchain the cache was created for.
+    Ref<BackendScene> scene;      //!< Scene the cache was created for.
+    size_t width, height;         //!< Size of the swapchain.
+    size_t samplesPerPixel;       //!< Number of cached primary samples per pixel.
+
+  private:
+    unsigned stamp;               //!< Stamp of the valid entries.
+    Entry* entries;               //!< Cached primary samples.
+  };
+}
+
+#endif
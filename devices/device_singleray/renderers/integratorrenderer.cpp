@@ -21,15 +21,19 @@
 
 /* include all samplers */
 #include "samplers/sampler.h"
+#include "samplers/sobolsampler.h"
 
 /* include all image filters */
 #include "filters/boxfilter.h"
 #include "filters/bsplinefilter.h"
 
+/* texture tile cache statistics */
+#include "textures/tilecache.h"
+
 namespace embree
 {
   IntegratorRenderer::IntegratorRenderer(const Parms& parms)
-    : iteration(0)
+    : iteration(0), sampleOffset(0), sampleTime(0.0)
   {
     /*! create integrator to use */
     std::string _integrator = parms.getString("integrator","pathtracer");
@@ -38,7 +42,8 @@ namespace embree
 
     /*! create sampler to use */
     std::string _samplers = parms.getString("sampler","multijittered");
-    if (_samplers == "multijittered"   ) samplers = new SamplerFactory(parms);
+    if      (_samplers == "multijittered"   ) samplers = new SamplerFactory(parms);
+    else if (_samplers == "sobol"           ) samplers = new SobolSamplerFactory(parms);
     else throw std::runtime_error("unknown sampler type: "+_samplers);
 
     /*! create pixel filter to use */
@@ -53,42 +58,118 @@ namespace embree
 
     /*! show progress to the user */
     showProgress = parms.getInt("showprogress",0);
+
+    /*! number of primary samples per pixel to cache for accumulation */
+    firstHitSamples = parms.getInt("firstHitCache",0);
+
+    /*! render time budget per frame in milliseconds */
+    frameBudget = 1E-3f*parms.getFloat("frameBudget",0.0f);
+
+    /*! maximal number of samples per pixel to reproject into a new view */
+    reprojection = max(0,parms.getInt("reprojection",0));
+
+    idle.signal();
   }
 
-  void IntegratorRenderer::renderFrame(const Ref<Camera>& camera, const Ref<BackendScene>& scene, const Ref<ToneMapper>& toneMapper, Ref<SwapChain > swapchain, int accumulate) 
+  void IntegratorRenderer::renderFrame(const Ref<Camera>& camera, const Ref<BackendScene>& scene, const Ref<ToneMapper>& toneMapper, Ref<SwapChain > swapchain, int accumulate) {
+    startFrame(camera,scene,toneMapper,swapchain,accumulate,NULL,false);
+  }
+
+  void IntegratorRenderer::renderFrameAsync(const Ref<Camera>& camera, const Ref<BackendScene>& scene, const Ref<ToneMapper>& toneMapper, Ref<SwapChain > swapchain, int accumulate, volatile int* cancel) {
+    startFrame(camera,scene,toneMapper,swapchain,accumulate,cancel,true);
+  }
+
+  void IntegratorRenderer::startFrame(const Ref<Camera>& camera, const Ref<BackendScene>& scene, const Ref<ToneMapper>& toneMapper, Ref<SwapChain > swapchain, int accumulate, volatile int* cancel, bool async) 
   {
-    if (accumulate == 0) iteration = 0;
-    new RenderJob(this,camera,scene,toneMapper,swapchain,accumulate,iteration);
+    /*! a cancelled frame finishes within one tile */
+    idle.wait();
+    idle.reset();
+
+    /*! a camera change reprojects the accumulation of the previous view instead of discarding it */
+    Ref<ReprojectionCache> history = null;
+    if (reprojection)
+    {
+      for (size_t i=0; i<reprojectionCaches.size(); i++)
+        if (reprojectionCaches[i]->matches(swapchain,scene)) history = reprojectionCaches[i];
+
+      /*! keep the caches of two swapchains for stereo rendering */
+      if (!history) {
+        if (reprojectionCaches.size() >= 2) reprojectionCaches.erase(reprojectionCaches.begin());
+        history = new ReprojectionCache(swapchain,scene);
+        reprojectionCaches.push_back(history);
+      }
+      history->next(camera,accumulate == 0);
+    }
+
+    /*! the sample sequence continues over reprojected frames, such that new samples do not repeat the history */
+    if (accumulate == 0 && !history) iteration = sampleOffset = 0;
+
+    /*! accumulation restarts whenever the camera changes, which invalidates all cached first hits */
+    Ref<FirstHitCache> firstHits = null;
+    if (firstHitSamples) 
+    {
+      if (accumulate == 0)
+        for (size_t i=0; i<firstHitCaches.size(); i++) firstHitCaches[i]->invalidate();
+      for (size_t i=0; i<firstHitCaches.size(); i++)
+        if (firstHitCaches[i]->matches(swapchain,scene)) firstHits = firstHitCaches[i];
+
+      /*! keep the caches of two swapchains for stereo rendering */
+      if (!firstHits) {
+        if (firstHitCaches.size() >= 2) firstHitCaches.erase(firstHitCaches.begin());
+        firstHits = new FirstHitCache(swapchain,scene,firstHitSamples);
+        firstHitCaches.push_back(firstHits);
+      }
+    }
+
+    /*! render only as many samples per pixel as fit into the frame budget, accumulation makes up for the rest */
+    size_t spp = samplers->samplesPerPixel;
+    if (frameBudget > 0.0f && sampleTime > 0.0) {
+      const double pixels = double(swapchain->getWidth())*double(swapchain->getHeight());
+      spp = max(size_t(1),size_t(min(double(spp),frameBudget/(sampleTime*pixels))));
+    }
+
+    new RenderJob(this,camera,scene,toneMapper,swapchain,accumulate,iteration,spp,firstHits,history,cancel,async);
     iteration++;
+    sampleOffset += int(spp);
   }
 
   IntegratorRenderer::RenderJob::RenderJob (Ref<IntegratorRenderer> renderer, const Ref<Camera>& camera, const Ref<BackendScene>& scene, 
-                                            const Ref<ToneMapper>& toneMapper, Ref<SwapChain > swapchain, int accumulate, int iteration)
+                                            const Ref<ToneMapper>& toneMapper, Ref<SwapChain > swapchain, int accumulate, int iteration,
+                                            size_t spp, const Ref<FirstHitCache>& firstHits, const Ref<ReprojectionCache>& history, 
+                                            volatile int* cancel, bool async)
     : renderer(renderer), camera(camera), scene(scene), toneMapper(toneMapper), swapchain(swapchain), 
-      accumulate(accumulate), iteration(iteration), tileID(0), atomicNumRays(0)
+      accumulate(accumulate), iteration(iteration), spp(spp), firstHits(firstHits), history(history), cancel(cancel), tileID(0), atomicNumRays(0)
   {
-    numTilesX = ((int)swapchain->getWidth() +TILE_SIZE-1)/TILE_SIZE;
+    numViews  = camera->numViews();
+    reprojecting = history && history->history && history->history->numViews() == numViews && accumulate == 0;
+    viewWidth = swapchain->getWidth()/numViews;
+    numTilesX = (swapchain->getWidth()-(numViews-1)*viewWidth+TILE_SIZE-1)/TILE_SIZE;
     numTilesY = ((int)swapchain->getHeight()+TILE_SIZE-1)/TILE_SIZE;
-    rcpWidth  = rcp(float(swapchain->getWidth()));
     rcpHeight = rcp(float(swapchain->getHeight()));
     this->framebuffer = swapchain->buffer();
-    this->framebuffer->startRendering(numTilesX*numTilesY);
-    if (renderer->showProgress) new (&progress) Progress(numTilesX*numTilesY);
+    this->framebuffer->startRendering(numViews*numTilesX*numTilesY);
+    if (renderer->showProgress) new (&progress) Progress(numViews*numTilesX*numTilesY);
 
     if (renderer->showProgress) progress.start();
     renderer->samplers->reset();
     renderer->integrator->requestSamples(renderer->samplers, scene);
-    renderer->samplers->init(iteration,renderer->filter);
-
-#if 1
-    TaskScheduler::EventSync event;
-    TaskScheduler::Task task(&event,_renderTile,this,TaskScheduler::getNumThreads(),_finish,this,"render::tile");
-    TaskScheduler::addTask(-1,TaskScheduler::GLOBAL_BACK,&task);
-    event.sync();
-#else
-    new (&task) TaskScheduler::Task (NULL,_renderTile,this,TaskScheduler::getNumThreads(),_finish,this,"render::tile");
-    TaskScheduler::addTask(-1,TaskScheduler::GLOBAL_BACK,&task);
-#endif
+    renderer->integrator->prepare(scene);
+    renderer->samplers->init(iteration,renderer->filter,renderer->sampleOffset);
+
+    /*! threads running out of tiles prepare the samples of the next accumulation iteration */
+    if (!renderer->samplers->procedural()) renderer->samplers->prepare(iteration+1);
+
+    /*! the finish function deletes the job, thus it must not be accessed after the task got added */
+    if (!async) {
+      TaskScheduler::EventSync event;
+      TaskScheduler::Task task(&event,_renderTile,this,TaskScheduler::getNumThreads(),_finish,this,"render::tile");
+      TaskScheduler::addTask(-1,TaskScheduler::GLOBAL_BACK,&task);
+      event.sync();
+    }
+    else {
+      new (&task) TaskScheduler::Task (NULL,_renderTile,this,TaskScheduler::getNumThreads(),_finish,this,"render::tile");
+      TaskScheduler::addTask(-1,TaskScheduler::GLOBAL_BACK,&task);
+    }
   }
 
   void IntegratorRenderer::RenderJob::finish(size_t threadIndex, size_t threadCount, TaskScheduler::Event* event)
@@ -96,6 +177,14 @@ namespace embree
     if (renderer->showProgress) progress.end();
     double dt = getSeconds()-t0;
 
+    /*! track the cost of a pixel sample for the frame budget, smoothed over frames */
+    const bool cancelled = cancel && *cancel;
+    if (!cancelled) {
+      const double t = dt/(double(spp)*double(swapchain->getWidth())*double(swapchain->getHeight()));
+      renderer->sampleTime = renderer->sampleTime > 0.0 ? 0.5*(renderer->sampleTime+t) : t;
+    }
+    if (history) history->finish(cancelled);
+
      /*! print fps, render time, and rays per second */
     std::ostringstream stream;
     stream << "render  ";
@@ -106,31 +195,186 @@ namespace embree
     stream << dt*1000.0f << " ms, ";
     stream.precision(3);
     stream << atomicNumRays/dt*1E-6 << " mrps";
+    if (renderer->frameBudget > 0.0f) stream << ", " << spp << " spp";
+    if (cancelled) stream << ", cancelled";
     std::cout << stream.str() << std::endl;
+    if (renderer->showProgress) TileCache::instance().printStatistics(std::cout);
 
     rtcDebug();
 
+    renderer->idle.signal();
     delete this;
   }
 
+  Vec4f IntegratorRenderer::RenderJob::reproject(size_t view, const Vector3f& P, const Vector3f& N, float t) const
+  {
+    /*! find the pixel that showed the hit point in the previous view */
+    const size_t view_x0 = view*viewWidth;
+    const size_t view_x1 = view+1 == numViews ? swapchain->getWidth() : view_x0+viewWidth;
+    Vec2f pixel;
+    if (!history->history->view(view)->project(P,pixel)) return Vec4f(zero);
+    if (pixel.x < 0.0f || pixel.x >= 1.0f || pixel.y < 0.0f || pixel.y >= 1.0f) return Vec4f(zero);
+    const size_t x = min(view_x0+size_t(pixel.x*float(view_x1-view_x0)),view_x1-1);
+    const size_t y = min(size_t(pixel.y*float(swapchain->getHeight())),swapchain->getHeight()-1);
+    const ReprojectionCache::Entry* e = history->getHistory(x,y);
+    if (!e) return Vec4f(zero);
+
+    /*! a disoccluded pixel showed another surface, which lies off the tangent plane or faces elsewhere */
+    if (abs(dot(e->P-P,N)) > 0.01f*t || dot(e->N,N) < 0.9f) return Vec4f(zero);
+
+    /*! clamp the weight of the history, such that view dependent shading adapts to the new view */
+    const float maxWeight = float(renderer->reprojection);
+    return e->color.w > maxWeight ? e->color*(maxWeight*rcp(e->color.w)) : e->color;
+  }
+
   void IntegratorRenderer::RenderJob::renderTile(size_t threadIndex, size_t threadCount, size_t taskIndex, size_t taskCount, TaskScheduler::Event* event)
   {
     /*! create a new sampler */
     IntegratorState state;
     if (taskIndex == taskCount-1) t0 = getSeconds();
+
+    /*! storage for samples generated on the fly, one per pixel of a tile */
+    Ref<SamplerFactory> samplers = renderer->samplers;
+    const bool procedural = samplers->procedural();
+    PrecomputedSample generated[TILE_SIZE*TILE_SIZE];
+    if (procedural) for (size_t i=0; i<TILE_SIZE*TILE_SIZE; i++) samplers->allocate(generated[i]);
+
+    /*! primary hits of a tile, they get shaded together */
+    PrimaryHit* hits = (PrimaryHit*) alignedMalloc(TILE_SIZE*TILE_SIZE*sizeof(PrimaryHit),64);
+    size_t hitPixel[TILE_SIZE*TILE_SIZE];
     
     /*! tile pick loop */
+    size_t tile = 0, view = numViews-1;
     while (true)
     {
-      /*! pick a new tile */
-      size_t tile = tileID++;
+      /*! pick a new tile, the same thread renders the corresponding tiles of all views in a row to keep the scene data cached */
+      if (++view == numViews) { tile = tileID++; view = 0; }
       if (tile >= numTilesX*numTilesY) break;
 
+      /*! skip the remaining tiles of a cancelled frame */
+      if (cancel && *cancel) {
+        if (renderer->showProgress) progress.next();
+        framebuffer->finishTile();
+        continue;
+      }
+
+      /*! the last view may be one pixel wider */
+      const size_t view_x0 = view*viewWidth;
+      const size_t view_x1 = view+1 == numViews ? swapchain->getWidth() : view_x0+viewWidth;
+      const Camera* camera = this->camera->view(view);
+      const float rcpWidth = rcp(float(view_x1-view_x0));
+
       /*! process all tile samples */
-      const int tile_x = (tile%numTilesX)*TILE_SIZE;
+      const int tile_x = int(view_x0 + (tile%numTilesX)*TILE_SIZE);
       const int tile_y = (tile/numTilesX)*TILE_SIZE;
+      if (size_t(tile_x) >= view_x1) {
+        if (renderer->showProgress) progress.next();
+        framebuffer->finishTile();
+        continue;
+      }
       Random randomNumberGenerator(tile_x * 91711 + tile_y * 81551 + 3433*swapchain->firstActiveLine());
-      
+      const bool chromatic = camera->chromatic();
+      const size_t n = min(size_t(TILE_SIZE),view_x1-tile_x);
+
+      /*! radiance and first hits for reprojection of each pixel of the tile */
+      Color L[TILE_SIZE*TILE_SIZE];
+      Vector3f firstP[TILE_SIZE*TILE_SIZE], firstN[TILE_SIZE*TILE_SIZE];
+      float firstT[TILE_SIZE*TILE_SIZE];
+      bool firstHit[TILE_SIZE*TILE_SIZE];
+
+      /*! pick the sample set of each pixel, pixels outside the lens of head mounted displays stay black */
+      int sets[TILE_SIZE*TILE_SIZE];
+      bool active[TILE_SIZE*TILE_SIZE];
+      for (size_t dy=0; dy<TILE_SIZE; dy++)
+      {
+        const size_t y = tile_y+dy;
+        for (size_t dx=0; dx<n; dx++) 
+        {
+          const size_t i = dy*TILE_SIZE+dx;
+          L[i] = Color(zero); firstHit[i] = false; active[i] = false;
+          if (y >= swapchain->getHeight() || !swapchain->activeLine(y)) continue;
+          sets[i] = randomNumberGenerator.getInt(samplers->sampleSets);
+          active[i] = camera->visible(Vec2f((float(tile_x+dx-view_x0)+0.5f)*rcpWidth,(float(y)+0.5f)*rcpHeight));
+        }
+      }
+
+      for (size_t s=0; s<spp; s++)
+      {
+        /*! trace the primary rays of the tile */
+        size_t numHits = 0;
+        for (size_t dy=0; dy<TILE_SIZE; dy++)
+        {
+          const size_t y = tile_y+dy;
+          for (size_t dx=0; dx<n; dx++)
+          {
+            const size_t i = dy*TILE_SIZE+dx;
+            if (!active[i]) continue;
+            const size_t x = tile_x+dx;
+
+            if (procedural) samplers->generate(int(x),int(y),int(s),generated[i]);
+            const PrecomputedSample& sample = procedural ? generated[i] : samplers->samples[sets[i]][s];
+            state.sample = &sample;
+
+            /*! iterations cycle through the cached primary samples of the pixel */
+            FirstHitCache::Entry* hit = firstHits && !chromatic ? &firstHits->get(x,y,(size_t(samplers->sampleOffset)+s)%firstHits->samplesPerPixel) : NULL;
+            if (hit && firstHits->valid(*hit)) {
+              PrimaryHit& h = hits[numHits]; hitPixel[numHits++] = i;
+              h.ray = hit->ray; h.dg = hit->dg; h.sample = &sample; h.pixel = hit->pixel;
+              if (history && s == 0 && h.ray) {
+                firstHit[i] = true; firstP[i] = hit->dg.P; firstN[i] = hit->dg.Ns; firstT[i] = h.ray.tfar;
+              }
+              continue;
+            }
+
+            const float fx = (float(x-view_x0) + sample.pixel.x)*rcpWidth;
+            const float fy = (float(y) + sample.pixel.y)*rcpHeight;
+            state.pixel = Vec2f(fx,fy);
+
+            /*! every color channel gets its own primary ray */
+            if (chromatic) {
+              for (int c=0; c<3; c++) {
+                Ray primary; camera->ray(Vec2f(fx,fy), sample.getLens(), c, primary);
+                primary.time = sample.getTime();
+                primary.dDdx = rcpWidth*primary.dDdx;
+                primary.dDdy = rcpHeight*primary.dDdy;
+                const Color Lc = renderer->integrator->Li(primary, scene, state);
+                L[i] += Color(c == 0 ? Lc.r : 0.0f, c == 1 ? Lc.g : 0.0f, c == 2 ? Lc.b : 0.0f);
+              }
+              continue;
+            }
+
+            PrimaryHit& h = hits[numHits]; hitPixel[numHits++] = i;
+            Ray& primary = h.ray;
+            camera->ray(Vec2f(fx,fy), sample.getLens(), primary);
+            primary.time = sample.getTime();
+            primary.dDdx = rcpWidth*primary.dDdx;
+            primary.dDdy = rcpHeight*primary.dDdy;
+            h.sample = &sample; h.pixel = state.pixel;
+
+            DifferentialGeometry& dg = h.dg;
+            rtcIntersect(scene->scene,(RTCRay&)primary);
+            new (&dg) DifferentialGeometry();
+            scene->postIntersect(primary,dg);
+            state.numRays++;
+
+            /*! fill the cache entry, the first sample of a pixel records its hit for reprojection */
+            if (hit) {
+              hit->ray = primary;
+              hit->dg = dg;
+              hit->pixel = state.pixel;
+              firstHits->validate(*hit);
+            }
+            if (history && s == 0 && primary) {
+              firstHit[i] = true; firstP[i] = dg.P; firstN[i] = dg.Ns; firstT[i] = primary.tfar;
+            }
+          }
+        }
+
+        /*! shade the primary hits of the tile together */
+        renderer->integrator->Li(hits, numHits, scene, state);
+        for (size_t k=0; k<numHits; k++) L[hitPixel[k]] += hits[k].L;
+      }
+
       for (size_t dy=0; dy<TILE_SIZE; dy++)
       {
         size_t y = tile_y+dy;
@@ -138,33 +382,34 @@ namespace embree
 
         if (!swapchain->activeLine(y)) continue;
         size_t _y = swapchain->raster2buffer(y);
-        
-        for (size_t dx=0; dx<TILE_SIZE; dx++)
+
+        /*! the radiance of the row is collected and resolved at once */
+        __align(16) float R[TILE_SIZE], G[TILE_SIZE], B[TILE_SIZE];
+        for (size_t dx=0; dx<n; dx++)
         {
-          size_t x = tile_x+dx;
-          if (x >= swapchain->getWidth()) continue;
+          const size_t i = dy*TILE_SIZE+dx;
+          R[dx] = L[i].r; G[dx] = L[i].g; B[dx] = L[i].b;
 
-          const int set = randomNumberGenerator.getInt(renderer->samplers->sampleSets);
+          /*! seed the accumulation with the history, pixels without history start over */
+          if (reprojecting)
+            swapchain->accu()->set(tile_x+dx, _y, firstHit[i] ? reproject(view,firstP[i],firstN[i],firstT[i]) : Vec4f(zero));
+        }
 
-          Color L = zero;
-          size_t spp = renderer->samplers->samplesPerPixel;
-          for (size_t s=0; s<spp; s++)
-          {
-            PrecomputedSample& sample = renderer->samplers->samples[set][s];
-            const float fx = (float(x) + sample.pixel.x)*rcpWidth;
-            const float fy = (float(y) + sample.pixel.y)*rcpHeight;
+        /*! accumulate, tonemap, and convert the row in one pass */
+        swapchain->update(tile_x, _y, R, G, B, n, float(spp), accumulate || reprojecting);
 
-            Ray primary; camera->ray(Vec2f(fx,fy), sample.getLens(), primary);
-            primary.time = sample.getTime();
-            
-            state.sample = &sample;
-            state.pixel = Vec2f(fx,fy);
-            L += renderer->integrator->Li(primary, scene, state);
+        /*! keep the accumulation and first hits as history for the next view */
+        if (history) {
+          for (size_t dx=0; dx<n; dx++) {
+            const size_t i = dy*TILE_SIZE+dx;
+            ReprojectionCache::Entry& e = history->get(tile_x+dx,y);
+            e.color = swapchain->accu()->getSum(tile_x+dx,_y);
+            e.P = firstP[i]; e.N = firstN[i];
+            e.frame = firstHit[i] ? history->frame : 0;
           }
-          const Color L0 = swapchain->update(x, _y, L, spp, accumulate);
-          const Color L1 = toneMapper->eval(L0,x,y,swapchain);
-          framebuffer->set(x, _y, L1);
         }
+        toneMapper->evalRow(R, G, B, n, tile_x, int(y), swapchain);
+        framebuffer->setRow(tile_x, _y, R, G, B, n);
       }
       
       /*! print progress bar */
@@ -174,6 +419,12 @@ namespace embree
       framebuffer->finishTile();
     }
 
+    alignedFree(hits);
+
+    /*! use the tail of the frame to prepare the samples of the next iteration */
+    if (procedural) for (size_t i=0; i<TILE_SIZE*TILE_SIZE; i++) samplers->deallocate(generated[i]);
+    else samplers->prepareSets();
+
     /*! we access the atomic ray counter only once per tile */
     atomicNumRays += state.numRays;
   }
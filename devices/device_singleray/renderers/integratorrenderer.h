@@ -22,6 +22,8 @@
 #include "../samplers/sampler.h"
 #include "../filters/filter.h"
 #include "../renderers/progress.h"
+#include "../renderers/firsthitcache.h"
+#include "../renderers/reprojectioncache.h"
 #include "common/sys/taskscheduler.h"
 
 namespace embree
@@ -38,16 +40,27 @@ namespace embree
     /*! Renders a single frame. */
     void renderFrame(const Ref<Camera>& camera, const Ref<BackendScene>& scene, const Ref<ToneMapper>& toneMapper, Ref<SwapChain > film, int accumulate);
 
+    /*! Starts rendering a frame and returns immediately. */
+    void renderFrameAsync(const Ref<Camera>& camera, const Ref<BackendScene>& scene, const Ref<ToneMapper>& toneMapper, Ref<SwapChain > film, int accumulate, volatile int* cancel);
+
   private:
 
+    /*! Starts rendering a frame after the previous frame finished. */
+    void startFrame(const Ref<Camera>& camera, const Ref<BackendScene>& scene, const Ref<ToneMapper>& toneMapper, Ref<SwapChain > film, int accumulate, volatile int* cancel, bool async);
+
     class RenderJob
     {
     public:
       RenderJob (Ref<IntegratorRenderer> renderer, const Ref<Camera>& camera, const Ref<BackendScene>& scene, 
-                 const Ref<ToneMapper>& toneMapper, Ref<SwapChain > swapchain, int accumulate, int iteration);
+                 const Ref<ToneMapper>& toneMapper, Ref<SwapChain > swapchain, int accumulate, int iteration,
+                 size_t spp, const Ref<FirstHitCache>& firstHits, const Ref<ReprojectionCache>& history, 
+                 volatile int* cancel, bool async);
        
     private:
 
+      /*! Returns the clamped history of a hit point, zero if the previous view showed a different surface. */
+      Vec4f reproject(size_t view, const Vector3f& P, const Vector3f& N, float t) const;
+
       /*! start functon */
       TASK_RUN_FUNCTION(RenderJob,renderTile);
       
@@ -64,12 +77,18 @@ namespace embree
       Ref<SwapChain > swapchain;   //!< Swapchain to render into
       int accumulate;                //!< Accumulation mode
       int iteration;
+      size_t spp;                    //!< Samples per pixel of this frame
+      Ref<FirstHitCache> firstHits;  //!< Cached primary hits (optional)
+      Ref<ReprojectionCache> history; //!< Accumulation of previous frames (optional)
+      bool reprojecting;             //!< The camera changed and the history gets reprojected.
+      volatile int* cancel;          //!< Skips the remaining tiles when nonzero (optional)
 
       /*! Precomputations. */
     private:
-      float rcpWidth;                //!< Reciprocal width of framebuffer.
       float rcpHeight;               //!< Reciprocal height of framebuffer.
-      size_t numTilesX;              //!< Number of tiles in x direction.
+      size_t numViews;               //!< Number of views side by side, 2 for stereo cameras.
+      size_t viewWidth;              //!< Width of all but the last view.
+      size_t numTilesX;              //!< Number of tiles of a view in x direction.
       size_t numTilesY;              //!< Number of tiles in y direction.
       
     private:
@@ -84,6 +103,8 @@ namespace embree
   private:
     int maxDepth;                  //!< Maximal recursion depth.
     float gamma;                   //!< Gamma to use for framebuffer writeback.
+    float frameBudget;             //!< Render time per frame in seconds the samples per pixel are reduced to, 0 disables the budget.
+    size_t reprojection;           //!< Maximal number of samples per pixel kept when reprojecting, 0 disables reprojection.
     
   private:
     Ref<Integrator> integrator;    //!< Integrator to use.
@@ -92,7 +113,19 @@ namespace embree
 
   private:
     int iteration;
+    int sampleOffset;              //!< Index of the first sample of the next frame in the sample sequence, frames may render different numbers of samples.
     bool showProgress;             //!< Set to true if user wants rendering progress shown
+    double sampleTime;             //!< Measured render time per pixel sample of the previous frames.
+    EventSys idle;                 //!< Signalled while no frame is rendered, frames share the sampler state.
+
+    /*! First hit caches for the most recently rendered swapchains. */
+  private:
+    size_t firstHitSamples;        //!< Number of cached primary samples per pixel, 0 disables the cache.
+    std::vector<Ref<FirstHitCache> > firstHitCaches;
+
+    /*! Reprojection caches for the most recently rendered swapchains. */
+  private:
+    std::vector<Ref<ReprojectionCache> > reprojectionCaches;
   };
 }
 
@@ -31,7 +31,7 @@ namespace embree
     /*! Constructs a ray from origin, direction, and ray segment. Near
      *  has to be smaller than far. */
     __forceinline Ray(const Vector3f& org, const Vector3f& dir, float tnear = zero, float tfar = inf, float time = zero, int mask = -1)
-      : org(org), dir(dir), tnear(tnear), tfar(tfar), id0(-1), id1(-1), mask(mask), time(time) {}
+      : org(org), dir(dir), tnear(tnear), tfar(tfar), id0(-1), id1(-1), mask(mask), time(time), dDdx(0.0f), dDdy(0.0f) {}
 
     /*! Tests if we hit something. */
     __forceinline operator bool() const { return id0 != -1; }
@@ -50,6 +50,10 @@ namespace embree
     float v;           //!< Barycentric v coordinate of hit
     int id0;           //!< 1st primitive ID
     int id1;           //!< 2nd primitive ID
+
+  public:
+    Vec3fa dDdx;       //!< Derivative of the direction with respect to the raster x coordinate
+    Vec3fa dDdy;       //!< Derivative of the direction with respect to the raster y coordinate
   };
 
   /*! Outputs ray to stream. */
@@ -42,6 +42,15 @@ namespace embree
                              const Ref<ToneMapper>&   toneMapper, /*!< Tonemapper to use.          */
                              Ref<SwapChain>           film,  /*!< Framebuffer to render into. */
                              int accumulate) = 0;               /*!< Accumulation mode.          */
+
+    /*! Starts rendering a frame and returns immediately, the frame is
+     *  done when the framebuffer finished all tiles. Remaining tiles
+     *  are skipped once *cancel becomes nonzero. Renders synchronously
+     *  by default. */
+    virtual void renderFrameAsync(const Ref<Camera>& camera, const Ref<BackendScene>& scene, const Ref<ToneMapper>& toneMapper, 
+                                  Ref<SwapChain> film, int accumulate, volatile int* cancel) {
+      renderFrame(camera,scene,toneMapper,film,accumulate);
+    }
     
   };
 }
@@ -0,0 +1,120 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#ifndef __EMBREE_REPROJECTION_CACHE_H__
+#define __EMBREE_REPROJECTION_CACHE_H__
+
+#include "../cameras/camera.h"
+#include "../api/scene.h"
+#include "../api/swapchain.h"
+
+namespace embree
+{
+  /*! Keeps the accumulated radiance together with the first hit of
+   *  each pixel, such that a camera change can reproject the
+   *  accumulation of the previous view instead of discarding it. The
+   *  frame writes one layer while the other holds the history of the
+   *  previous view. A view only becomes history once one of its frames
+   *  finished, as a cancelled frame leaves tiles unrendered. The cache
+   *  needs 2*sizeof(Entry) bytes per pixel. */
+  class ReprojectionCache : public RefCount
+  {
+    ALIGNED_CLASS
+  public:
+
+    /*! The accumulation and first hit of a pixel. */
+    struct Entry
+    {
+      Vec4f color;                //!< Accumulated radiance and weight.
+      Vector3f P;                 //!< First hit of the pixel.
+      Vector3f N;                 //!< Shading normal at the first hit.
+      unsigned frame;             //!< Frame that wrote the entry, 0 if the pixel missed the scene.
+    };
+
+    /*! Creates an empty cache for a swapchain and scene. */
+    ReprojectionCache (const Ref<SwapChain>& swapchain, const Ref<BackendScene>& scene)
+      : swapchain(swapchain), scene(scene), width(swapchain->getWidth()), height(swapchain->getHeight()), frame(0), viewFrame(1), viewComplete(false), historyStart(1), historyFrame(0)
+    {
+      for (size_t i=0; i<2; i++) {
+        layers[i] = (Entry*) alignedMalloc(width*height*sizeof(Entry),64);
+        for (size_t j=0; j<width*height; j++) layers[i][j].frame = 0;
+      }
+    }
+
+    ~ReprojectionCache () {
+      alignedFree(layers[0]);
+      alignedFree(layers[1]);
+    }
+
+    /*! Tests if the cache was created for a swapchain and scene. */
+    __forceinline bool matches(const Ref<SwapChain>& swapchain, const Ref<BackendScene>& scene) const {
+      return this->swapchain == swapchain && this->scene == scene && width == swapchain->getWidth() && height == swapchain->getHeight();
+    }
+
+    /*! Starts a new frame. When the camera changed, the frames of the
+     *  previous view become the history the new frame reprojects from.
+     *  If all frames of the previous view got cancelled, the history of
+     *  the view before is kept. */
+    void next(const Ref<Camera>& camera, bool cameraChanged)
+    {
+      if (cameraChanged) {
+        if (viewComplete) {
+          std::swap(layers[0],layers[1]);
+          history = this->camera;
+          historyStart = viewFrame;
+          historyFrame = frame;
+        }
+        viewFrame = frame+1;
+        viewComplete = false;
+      }
+      this->camera = camera;
+      frame++;
+    }
+
+    /*! Ends the current frame, a frame that was not cancelled rendered every pixel of the view. */
+    void finish(bool cancelled) {
+      if (!cancelled) viewComplete = true;
+    }
+
+    /*! Returns the entry the current frame writes for a pixel. */
+    __forceinline Entry& get(size_t x, size_t y) {
+      return layers[0][y*width+x];
+    }
+
+    /*! Returns the history entry of a pixel, NULL if no frame of the history view hit the scene at the pixel. */
+    __forceinline const Entry* getHistory(size_t x, size_t y) const {
+      const Entry& e = layers[1][y*width+x];
+      return e.frame >= historyStart && e.frame <= historyFrame ? &e : NULL;
+    }
+
+  public:
+    Ref<SwapChain> swapchain;     //!< Swapchain the cache was created for.
+    Ref<BackendScene> scene;      //!< Scene the cache was created for.
+    size_t width, height;         //!< Size of the swapchain.
+    Ref<Camera> camera;           //!< Camera of the current frame.
+    Ref<Camera> history;          //!< Camera of the history, NULL if there is none.
+    unsigned frame;               //!< Stamp of the current frame.
+
+  private:
+    unsigned viewFrame;           //!< Stamp of the first frame of the current view.
+    bool viewComplete;            //!< True if a frame of the current view finished without being cancelled.
+    unsigned historyStart;        //!< Stamp of the first frame of the history view.
+    unsigned historyFrame;        //!< Stamp of the last frame of the history view.
+    Entry* layers[2];             //!< Current frame and history.
+  };
+}
+
+#endif
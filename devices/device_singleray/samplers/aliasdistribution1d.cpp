@@ -0,0 +1,128 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "aliasdistribution1d.h"
+#include <algorithm>
+
+namespace embree
+{
+  AliasDistribution1D::AliasDistribution1D()
+    : size(0), PDF(NULL), Q(NULL), alias(NULL) {}
+
+  AliasDistribution1D::AliasDistribution1D(const float* f, const size_t size_in)
+    : size(0), PDF(NULL), Q(NULL), alias(NULL) {
+    init(f, size_in);
+  }
+
+  AliasDistribution1D::~AliasDistribution1D() {
+    if (PDF  ) { delete[] PDF;   PDF   = NULL; }
+    if (Q    ) { delete[] Q;     Q     = NULL; }
+    if (alias) { delete[] alias; alias = NULL; }
+  }
+
+  void AliasDistribution1D::readback(float *cdf, float *pdf)
+  {
+    assert(PDF);
+    std::copy(PDF,PDF+size,pdf);
+
+    /*! the CDF is not needed for sampling and recomputed here */
+    cdf[0] = 0.0f;
+    for (size_t i=1; i<size+1; i++)
+      cdf[i] = cdf[i-1] + PDF[i-1] * rcp(float(size));
+    cdf[size] = 1.0f;
+  }
+
+  void AliasDistribution1D::init(const float* f, const size_t size_in)
+  {
+    /*! create arrays */
+    if (PDF  ) delete[] PDF;
+    if (Q    ) delete[] Q;
+    if (alias) delete[] alias;
+    size = size_in;
+    PDF = new float[size];
+    Q = new float[size];
+    alias = new int[size];
+
+    /*! compute reciprocal sum of the function f */
+    float sum = 0.0f;
+    for (size_t i=0; i<size; i++) sum += f[i];
+    float rcpSum = sum == 0.0f ? 0.0f : rcp(sum);
+
+    /*! normalize the probability distribution */
+    for (size_t i=0; i<size; i++)
+      PDF[i] = f[i] * rcpSum * size;
+
+    /*! a zero function is sampled uniformly */
+    if (rcpSum == 0.0f) {
+      for (size_t i=0; i<size; i++) { Q[i] = 1.0f; alias[i] = int(i); }
+      return;
+    }
+
+    /*! build the alias table by pairing each element below the mean
+     *  with one above it, small elements are stacked at the front of
+     *  the work array and large ones at the back */
+    int* work = new int[size];
+    size_t numSmall = 0, numLarge = 0;
+    for (size_t i=0; i<size; i++) {
+      Q[i] = PDF[i];
+      if (Q[i] < 1.0f) work[numSmall++] = int(i);
+      else             work[size-1-numLarge++] = int(i);
+    }
+
+    while (numSmall && numLarge) {
+      int s = work[--numSmall];
+      int l = work[size-numLarge--];
+      alias[s] = l;
+      Q[l] = (Q[l]+Q[s])-1.0f;
+      if (Q[l] < 1.0f) work[numSmall++] = l;
+      else             work[size-1-numLarge++] = l;
+    }
+
+    /*! remaining elements are only off by rounding errors */
+    while (numSmall) { int s = work[--numSmall];      Q[s] = 1.0f; alias[s] = s; }
+    while (numLarge) { int l = work[size-numLarge--]; Q[l] = 1.0f; alias[l] = l; }
+    delete[] work;
+  }
+
+  Sample1f AliasDistribution1D::sample(const float u) const
+  {
+    const DistributionSample s = sampleElement(u);
+    return Sample1f(float(s.index)+s.fraction,s.pdf);
+  }
+
+  DistributionSample AliasDistribution1D::sampleElement(const float u) const
+  {
+    /*! pick a cell uniformly and keep it or jump to its alias */
+    float x = u*float(size);
+    int index = clamp(int(x),0,int(size)-1);
+    float fraction = x-float(index);
+    const float q = Q[index];
+
+    /*! reuse the fraction to place the sample inside the chosen element */
+    if (fraction < q) fraction = fraction * rcp(q);
+    else { fraction = (fraction-q) * rcp(1.0f-q); index = alias[index]; }
+
+    DistributionSample s;
+    s.index = index;
+    s.fraction = clamp(fraction,0.0f,1.0f-float(ulp));
+    s.pdf = PDF[index];
+    return s;
+  }
+
+  float AliasDistribution1D::pdf(const float p) const {
+    return PDF[clamp(int(p*size),0,int(size)-1)];
+  }
+}
@@ -0,0 +1,71 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#ifndef __EMBREE_ALIAS_DISTRIBUTION_1D_H__
+#define __EMBREE_ALIAS_DISTRIBUTION_1D_H__
+
+#include "distribution1d.h"
+
+namespace embree
+{
+  /*! 1D probability distribution sampled with an alias table in
+   *  constant time independent of the number of elements. The
+   *  sampled element is not monotonic in the random number, thus the
+   *  distribution scrambles stratified samples and should only be
+   *  used where the order of the samples does not matter, such as to
+   *  select between lights or light elements. */
+  class AliasDistribution1D
+  {
+  public:
+
+    /*! Default construction. */
+    AliasDistribution1D();
+
+    /*! Construction from distribution array f. */
+    AliasDistribution1D(const float* f, const size_t size);
+
+    /*! Destruction. */
+    ~AliasDistribution1D();
+
+    /*! Initialized the PDF and alias table arrays. */
+    void init(const float* f, const size_t size);
+
+    /*! read back the x-cdf and x-pdf data for given y (for SPMD
+        device offload). cdf is of size 'size+1', pdf of size
+        'size' */
+    void readback(float *cdf, float *pdf);
+  public:
+
+    /*! Draws a sample from the distribution. \param u is a random
+     *  number to use for sampling */
+    Sample1f sample(const float u) const;
+
+    /*! Draws an element from the distribution. \param u is a random
+     *  number to use for sampling */
+    DistributionSample sampleElement(const float u) const;
+
+    /*! Returns the probability density a sample would be drawn from location p. */
+    float pdf(const float p) const;
+
+  private:
+    size_t size;  //!< Number of elements in the PDF
+    float* PDF;   //!< Probability distribution function
+    float* Q;     //!< Probability to keep an element instead of taking its alias
+    int*   alias; //!< Element to take instead with probability 1-Q
+  };
+}
+
+#endif
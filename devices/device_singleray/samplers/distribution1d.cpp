@@ -22,13 +22,14 @@ namespace embree
   Distribution1D::Distribution1D()
     : size(0), PDF(NULL), CDF(NULL) {}
 
-  Distribution1D::Distribution1D(const float* f, const size_t size_in) {
+  Distribution1D::Distribution1D(const float* f, const size_t size_in)
+    : size(0), PDF(NULL), CDF(NULL) {
     init(f, size_in);
   }
 
   Distribution1D::~Distribution1D() {
-    if (PDF) delete[] PDF; PDF = NULL;
-    if (CDF) delete[] CDF; CDF = NULL;
+    if (PDF) { delete[] PDF; PDF = NULL; }
+    if (CDF) { delete[] CDF; CDF = NULL; }
   }
 
   void Distribution1D::readback(float *cdf, float *pdf)
@@ -42,6 +43,8 @@ namespace embree
   void Distribution1D::init(const float* f, const size_t size_in)
   {
     /*! create arrays */
+    if (PDF) delete[] PDF;
+    if (CDF) delete[] CDF;
     size = size_in;
     PDF = new float[size];
     CDF = new float[size+1];
@@ -58,7 +61,7 @@ namespace embree
     for (size_t i = 1; i<size+1; i++) {
       PDF[i-1] = f[i-1] * rcpSum * size;
       CDF[i] *= rcpSum;
-     }
+    }
     CDF[size] = 1.0f;
   }
 
@@ -73,8 +76,19 @@ namespace embree
     return Sample1f(float(index)+fraction,PDF[index]);
   }
 
+  DistributionSample Distribution1D::sampleElement(const float u) const
+  {
+    float* pointer = std::upper_bound(CDF, CDF+size, u);
+    int index = clamp(int(pointer-CDF-1),0,int(size)-1);
+
+    DistributionSample s;
+    s.index = index;
+    s.fraction = clamp((u - CDF[index]) * rcp(CDF[index+1] - CDF[index]),0.0f,1.0f-float(ulp));
+    s.pdf = PDF[index];
+    return s;
+  }
+
   float Distribution1D::pdf(const float p) const {
     return PDF[clamp(int(p*size),0,int(size)-1)];
   }
 }
-
@@ -21,9 +21,21 @@
 
 namespace embree
 {
+  /*! Element of a 1D distribution drawn by a sample. The position
+   *  inside the element is kept apart from the index, such that it
+   *  keeps its precision for distributions with many elements. */
+  struct DistributionSample
+  {
+    size_t index;    //!< Index of the sampled element
+    float fraction;  //!< Position of the sample inside the element in [0,1)
+    float pdf;       //!< Probability density of the sample
+  };
+
   /*! 1D probability distribution. The probability distribution
    *  function (PDF) can be initialized with arbitrary data and be
-   *  sampled. */
+   *  sampled. Sampling inverts the cumulative distribution function,
+   *  which is monotonic in the random number and thus preserves the
+   *  stratification of the samples. */
   class Distribution1D
   {
   public:
@@ -50,6 +62,10 @@ namespace embree
      *  number to use for sampling */
     Sample1f sample(const float u) const;
 
+    /*! Draws an element from the distribution. \param u is a random
+     *  number to use for sampling */
+    DistributionSample sampleElement(const float u) const;
+
     /*! Returns the probability density a sample would be drawn from location p. */
     float pdf(const float p) const;
 
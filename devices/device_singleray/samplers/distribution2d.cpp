@@ -18,29 +18,54 @@
 
 namespace embree
 {
-  Distribution2D::Distribution2D()
-    : width(0), height(0), xDists(NULL) {}
+  template<typename Distribution1>
+  Distribution2DT<Distribution1>::Distribution2DT()
+    : f(NULL), fy(NULL), width(0), height(0), xDists(NULL) {}
 
-  Distribution2D::Distribution2D(const float** f, const size_t width, const size_t height)
-    : width(width), height(height), xDists(NULL)
+  template<typename Distribution1>
+  Distribution2DT<Distribution1>::Distribution2DT(const float** f, const size_t width, const size_t height)
+    : f(NULL), fy(NULL), width(width), height(height), xDists(NULL)
   {
     init(f, width, height);
   }
 
-  Distribution2D::~Distribution2D() {
-    if (xDists) delete[] xDists; xDists = NULL;
+  template<typename Distribution1>
+  Distribution2DT<Distribution1>::~Distribution2DT() {
+    if (xDists) { delete[] xDists; xDists = NULL; }
   }
 
-  void Distribution2D::init(const float** f, const size_t w, const size_t h)
+  template<typename Distribution1>
+  void Distribution2DT<Distribution1>::init(const float** f_in, const size_t w, const size_t h)
   {
     /*! create arrays */
     if (xDists) delete[] xDists;
     width = w; height = h;
-    xDists = new Distribution1D[height];
-    float* fy = new float[height];
+    xDists = new Distribution1[height];
+    fy = new float[height];
+    f = f_in;
 
     /*! compute y distribution and initialize row distributions */
-    for (size_t y=0; y<height; y++)
+    if (width*height < 64*1024) 
+      initRows(0,1,0,1,NULL);
+    else {
+      TaskScheduler::EventSync event;
+      TaskScheduler::Task task(&event,_initRows,this,TaskScheduler::getNumThreads(),NULL,NULL,"distribution2d::init");
+      TaskScheduler::addTask(-1,TaskScheduler::GLOBAL_FRONT,&task);
+      event.sync();
+    }
+
+    /*! initializes the y distribution */
+    yDist.init(fy, height);
+    delete[] fy; fy = NULL;
+    f = NULL;
+  }
+
+  template<typename Distribution1>
+  void Distribution2DT<Distribution1>::initRows(size_t threadIndex, size_t threadCount, size_t taskIndex, size_t taskCount, TaskScheduler::Event* event)
+  {
+    const size_t y0 = (taskIndex+0)*height/taskCount;
+    const size_t y1 = (taskIndex+1)*height/taskCount;
+    for (size_t y=y0; y<y1; y++)
     {
       /*! accumulate row to compute y distribution */
       fy[y] = 0.0f;
@@ -50,13 +75,10 @@ namespace embree
       /*! initialize distribution for current row */
       xDists[y].init(f[y], width);
     }
-
-    /*! initializes the y distribution */
-    yDist.init(fy, height);
-    delete[] fy;
   }
 
-  Sample2f Distribution2D::sample(const Vec2f& u) const
+  template<typename Distribution1>
+  Sample2f Distribution2DT<Distribution1>::sample(const Vec2f& u) const
   {
     /*! use u.y to sample a row */
     Sample1f sy = yDist.sample(u.y);
@@ -67,8 +89,13 @@ namespace embree
     return Sample2f(Vec2f(sx,sy),sx.pdf*sy.pdf);
   }
 
-  float Distribution2D::pdf(const Vec2f& p) const {
+  template<typename Distribution1>
+  float Distribution2DT<Distribution1>::pdf(const Vec2f& p) const {
     int idx = clamp(int(p.y*height),0,int(height)-1);
     return xDists[idx].pdf(p.x) * yDist.pdf(p.y);
   }
+
+  /*! template instantiations */
+  template class Distribution2DT<Distribution1D>;
+  template class Distribution2DT<AliasDistribution1D>;
 }
@@ -18,26 +18,31 @@
 #define __EMBREE_DISTRIBUTION_2D_H__
 
 #include "distribution1d.h"
+#include "aliasdistribution1d.h"
+#include "sys/taskscheduler.h"
 
 namespace embree
 {
   /*! 2D probability distribution. The probability distribution
    *  function (PDF) can be initialized with arbitrary data and be
-   *  sampled. */
-  class Distribution2D : public RefCount
+   *  sampled. Rows and the row selection are sampled with the 1D
+   *  distribution Distribution1. */
+  template<typename Distribution1>
+  class Distribution2DT : public RefCount
   {
   public:
 
     /*! Default construction. */
-    Distribution2D();
+    Distribution2DT();
 
     /*! Construction from 2D distribution array f. */
-    Distribution2D(const float** f, const size_t width, const size_t height);
+    Distribution2DT(const float** f, const size_t width, const size_t height);
 
     /*! Destruction. */
-    ~Distribution2D();
+    ~Distribution2DT();
 
-    /*! Initialized the PDF and CDF arrays. */
+    /*! Initialized the PDF and CDF arrays. Rows of large
+     *  distributions are initialized in parallel. */
     void init(const float** f, const size_t width, const size_t height);
 
     /*! read back the y-cdf and y-pdf data (for SPMD device
@@ -61,12 +66,25 @@ namespace embree
      *  location p. */
     float pdf(const Vec2f& p) const;
 
+  private:
+    TASK_RUN_FUNCTION(Distribution2DT,initRows);
+
+  private:
+    const float** f;         //!< Function during initialization
+    float* fy;               //!< Row sums during initialization
+
   private:
     size_t width;            //!< Number of elements in x direction
     size_t height;           //!< Number of elements in y direction
-    Distribution1D yDist;    //!< Distribution to select between rows
-    Distribution1D* xDists;  //!< One 1D Distribution per row
+    Distribution1 yDist;     //!< Distribution to select between rows
+    Distribution1* xDists;   //!< One 1D Distribution per row
   };
+
+  /*! 2D distribution that inverts the CDFs and thus preserves the stratification of the samples. */
+  typedef Distribution2DT<Distribution1D> Distribution2D;
+
+  /*! 2D distribution sampled with alias tables, for lights where the order of the samples does not matter. */
+  typedef Distribution2DT<AliasDistribution1D> AliasDistribution2D;
 }
 
 #endif
@@ -22,7 +22,8 @@ namespace embree
 {
   SamplerFactory::SamplerFactory(const Parms& parms)
     : numSamples1D(0), numSamples2D(0), numLightSamples(0),
-      samplesPerPixel(1), sampleSets(64), samples(NULL)
+      samplesPerPixel(1), sampleSets(64), samples(NULL), iteration(0), sampleOffset(0),
+      active(new Chunk), next(new Chunk)
   {
     samplesPerPixel = parms.getInt("sampler.spp",1);
     samplesPerPixel = max(1,samplesPerPixel);
@@ -33,12 +34,16 @@ namespace embree
   SamplerFactory::SamplerFactory(const unsigned samplesPerPixel,
                                  const unsigned sampleSets)
     : numSamples1D(0), numSamples2D(0), numLightSamples(0),
-      samplesPerPixel(samplesPerPixel), sampleSets(sampleSets), samples(NULL) 
+      samplesPerPixel(samplesPerPixel), sampleSets(sampleSets), samples(NULL), iteration(0), sampleOffset(0),
+      active(new Chunk), next(new Chunk)
   {
   }
 
-  SamplerFactory::~SamplerFactory() {
-    reset();
+  SamplerFactory::~SamplerFactory() 
+  {
+    freeChunk(active); delete active; active = NULL;
+    freeChunk(next);   delete next;   next   = NULL;
+    delete[] samples; samples = NULL;
   }
 
   int SamplerFactory::request1D(int num)
@@ -65,86 +70,116 @@ namespace embree
 
   void SamplerFactory::reset()
   {
-    if (samples) {
-      for (int set = 0; set < sampleSets; set++) {
-        for (int s = 0; s < samplesPerPixel; s++) {
-          delete[] samples[set][s].samples1D;
-          delete[] samples[set][s].samples2D;
-          delete[] samples[set][s].lightSamples;
-        }
-        delete[] samples[set];
-      }
-      delete[] samples;
-    }
-    samples = NULL;
     numSamples1D = 0;
     numSamples2D = 0;
     numLightSamples = 0;
+    lights.clear();
+    lightBaseSamples.clear();
   }
 
-  void SamplerFactory::init(int iteration, const Ref<Filter> filter)
+  bool SamplerFactory::matches(const Chunk* chunk, int id, const Ref<Filter>& filter) const
   {
-    this->iteration = iteration;
-    samples = new PrecomputedSample*[sampleSets];
-    if (samplesPerPixel != (1 << __bsf(samplesPerPixel)))
-      throw std::runtime_error("Number of samples per pixel have to be a power of two.");
+    return chunk->id == id && chunk->size == chunkSize() && chunk->filter == filter &&
+      chunk->numSamples1D == numSamples1D && chunk->numSamples2D == numSamples2D &&
+      chunk->lights == lights && chunk->lightBaseSamples == lightBaseSamples;
+  }
+
+  void SamplerFactory::initChunk(Chunk* chunk, int id, const Ref<Filter>& filter)
+  {
+    freeChunk(chunk);
+    chunk->id = id;
+    chunk->size = chunkSize();
+    chunk->numSamples1D = numSamples1D;
+    chunk->numSamples2D = numSamples2D;
+    chunk->lights = lights;
+    chunk->lightBaseSamples = lightBaseSamples;
+    chunk->filter = filter;
+    chunk->nextSet = 0;
+    chunk->doneSets = 0;
+
+    /*! the additional samples of a set are stored contiguously */
+    const int N = chunk->size;
+    chunk->sets = new PrecomputedSample*[sampleSets];
+    for (int set = 0; set < sampleSets; set++) {
+      PrecomputedSample* samples = chunk->sets[set] = new PrecomputedSample[N];
+      float* samples1D = new float[N*numSamples1D];
+      Vec2f* samples2D = new Vec2f[N*numSamples2D];
+      LightSample* lightSamples = new LightSample[N*lights.size()];
+      for (int s = 0; s < N; s++) {
+        samples[s].samples1D = samples1D + s*numSamples1D;
+        samples[s].samples2D = samples2D + s*numSamples2D;
+        samples[s].lightSamples = lightSamples + s*lights.size();
+      }
+    }
+  }
 
-    int chunkSize = max((int)samplesPerPixel,64);
-    int currentChunk = int(iteration*samplesPerPixel) / chunkSize;
-    int offset = (iteration*samplesPerPixel) % chunkSize;
+  void SamplerFactory::freeChunk(Chunk* chunk)
+  {
+    if (chunk->sets) {
+      for (int set = 0; set < sampleSets; set++) {
+        delete[] chunk->sets[set][0].samples1D;
+        delete[] chunk->sets[set][0].samples2D;
+        delete[] chunk->sets[set][0].lightSamples;
+        delete[] chunk->sets[set];
+      }
+      delete[] chunk->sets;
+    }
+    chunk->sets = NULL;
+    chunk->id = -1;
+    chunk->lights.clear();
+    chunk->filter = null;
+  }
+
+  void SamplerFactory::generateSet(Chunk* chunk, int set)
+  {
+    /*! every set has its own random sequence and can be generated independently */
+    const int N = chunk->size;
     Random rng;
-    rng.setSeed(currentChunk * 5897);
+    rng.setSeed(chunk->id * 5897 + set * 7919);
 
-    Vec2f* pixel = new Vec2f[chunkSize];
-    float* time = new float[chunkSize];
-    Vec2f* lens = new Vec2f[chunkSize];
-    float* samples1D = new float[chunkSize];
-    Vec2f* samples2D = new Vec2f[chunkSize];
+    Vec2f* pixel = new Vec2f[N];
+    float* time = new float[N];
+    Vec2f* lens = new Vec2f[N];
+    float* samples1D = new float[N];
+    Vec2f* samples2D = new Vec2f[N];
+    PrecomputedSample* samples = chunk->sets[set];
 
-    for (int set = 0; set < sampleSets; set++)
-    {
-      samples[set] = new PrecomputedSample[samplesPerPixel];
-
-      /*! Generate pixel and lens samples. */
-      multiJittered(pixel, chunkSize, rng);
-      jittered(time, chunkSize, rng);
-      multiJittered(lens, chunkSize, rng);
-      for (int s = 0; s < samplesPerPixel; s++) {
-        samples[set][s].pixel = pixel[offset + s];
-        samples[set][s].time = time[offset + s];
-        samples[set][s].lens = lens[offset + s];
-        if (filter) {
-          samples[set][s].pixel = filter->sample(samples[set][s].pixel) + Vec2f(0.5f, 0.5f);
-        }
-        samples[set][s].samples1D = new float[SamplerFactory::numSamples1D];
-        samples[set][s].samples2D = new Vec2f[SamplerFactory::numSamples2D];
-        samples[set][s].lightSamples = new LightSample[SamplerFactory::numLightSamples];
+    /*! Generate pixel and lens samples. */
+    multiJittered(pixel, N, rng);
+    jittered(time, N, rng);
+    multiJittered(lens, N, rng);
+    for (int s = 0; s < N; s++) {
+      samples[s].pixel = pixel[s];
+      samples[s].time = time[s];
+      samples[s].lens = lens[s];
+      if (chunk->filter) {
+        samples[s].pixel = chunk->filter->sample(samples[s].pixel) + Vec2f(0.5f, 0.5f);
       }
+    }
 
-      /*! Generate requested 1D samples. */
-      for (int d = 0; d < SamplerFactory::numSamples1D; d++) {
-        jittered(samples1D, chunkSize, rng);
-        for (int s = 0; s < samplesPerPixel; s++) {
-          samples[set][s].samples1D[d] = samples1D[offset + s];
-        }
+    /*! Generate requested 1D samples. */
+    for (int d = 0; d < chunk->numSamples1D; d++) {
+      jittered(samples1D, N, rng);
+      for (int s = 0; s < N; s++) {
+        samples[s].samples1D[d] = samples1D[s];
       }
+    }
 
-      /*! Generate 2D samples. */
-      for (int d = 0; d < SamplerFactory::numSamples2D; d++) {
-        multiJittered(samples2D, chunkSize, rng);
-        for (int s = 0; s < samplesPerPixel; s++) {
-          samples[set][s].samples2D[d] = samples2D[offset + s];
-        }
+    /*! Generate 2D samples. */
+    for (int d = 0; d < chunk->numSamples2D; d++) {
+      multiJittered(samples2D, N, rng);
+      for (int s = 0; s < N; s++) {
+        samples[s].samples2D[d] = samples2D[s];
       }
+    }
 
-      /*! Generate light samples. */
-      for (int d = 0; d < SamplerFactory::numLightSamples; d++) {
-        for (int s = 0; s < samplesPerPixel; s++) {
-          LightSample ls;
-          DifferentialGeometry dg;
-          ls.L = lights[d]->sample(dg, ls.wi, ls.tMax, samples[set][s].samples2D[lightBaseSamples[d]]);
-          samples[set][s].lightSamples[d] = ls;
-        }
+    /*! Generate light samples. */
+    for (size_t d = 0; d < chunk->lights.size(); d++) {
+      for (int s = 0; s < N; s++) {
+        LightSample ls;
+        DifferentialGeometry dg;
+        ls.L = chunk->lights[d]->sample(dg, ls.wi, ls.tMax, samples[s].samples2D[chunk->lightBaseSamples[d]]);
+        samples[s].lightSamples[d] = ls;
       }
     }
     
@@ -155,6 +190,78 @@ namespace embree
     delete[] samples2D;
   }
 
+  void SamplerFactory::generateSets(size_t threadIndex, size_t threadCount, size_t taskIndex, size_t taskCount, TaskScheduler::Event* event) {
+    generateSet(active,int(taskIndex));
+  }
+
+  void SamplerFactory::init(int iteration, const Ref<Filter> filter, int sampleOffset)
+  {
+    this->iteration = iteration;
+    this->sampleOffset = sampleOffset < 0 ? iteration*samplesPerPixel : sampleOffset;
+    if (samplesPerPixel != (1 << __bsf(samplesPerPixel)))
+      throw std::runtime_error("Number of samples per pixel have to be a power of two.");
+
+    int currentChunk = int(iteration*samplesPerPixel) / chunkSize();
+    int offset = (iteration*samplesPerPixel) % chunkSize();
+
+    /*! use the prepared chunk or precompute the chunk in parallel */
+    if (!matches(active,currentChunk,filter)) 
+    {
+      if (matches(next,currentChunk,filter) && next->doneSets == sampleSets) 
+        std::swap(active,next);
+      else {
+        initChunk(active,currentChunk,filter);
+        TaskScheduler::EventSync event;
+        TaskScheduler::Task task(&event,_generateSets,this,sampleSets,NULL,NULL,"sampler::init");
+        TaskScheduler::addTask(-1,TaskScheduler::GLOBAL_FRONT,&task);
+        event.sync();
+      }
+    }
+
+    /*! the samples of this iteration start at the offset inside the chunk */
+    if (!samples) samples = new PrecomputedSample*[sampleSets];
+    for (int set = 0; set < sampleSets; set++)
+      samples[set] = active->sets[set] + offset;
+  }
+
+  void SamplerFactory::prepare(int iteration)
+  {
+    int id = int(iteration*samplesPerPixel) / chunkSize();
+
+    /*! nothing to prepare if the iteration stays inside the active chunk */
+    if (matches(active,id,active->filter)) {
+      next->nextSet = sampleSets;
+      return;
+    }
+    if (matches(next,id,active->filter)) return;
+    initChunk(next,id,active->filter);
+  }
+
+  void SamplerFactory::prepareSets()
+  {
+    if (next->id < 0) return;
+    while (true) {
+      atomic_t set = next->nextSet++;
+      if (set >= sampleSets) break;
+      generateSet(next,int(set));
+      next->doneSets++;
+    }
+  }
+
+  void SamplerFactory::allocate(PrecomputedSample& sample) const
+  {
+    sample.samples1D = new float[numSamples1D];
+    sample.samples2D = new Vec2f[numSamples2D];
+    sample.lightSamples = new LightSample[numLightSamples];
+  }
+
+  void SamplerFactory::deallocate(PrecomputedSample& sample) const
+  {
+    delete[] sample.samples1D; sample.samples1D = NULL;
+    delete[] sample.samples2D; sample.samples2D = NULL;
+    delete[] sample.lightSamples; sample.lightSamples = NULL;
+  }
+
   Sampler* SamplerFactory::create() {
     return new Sampler(this);
   }
@@ -21,6 +21,8 @@
 #include "math/random.h"
 #include "lights/light.h"
 #include "filters/filter.h"
+#include "sys/taskscheduler.h"
+#include "sys/sync/atomic.h"
 
 namespace embree
 {
@@ -115,7 +117,12 @@ namespace embree
     int currentSet;               //!< Index of the precomputed sample set that is used for current pixel.
   };
 
-  /*! The sampler factory precomputes samples for usage by multiple samlper threads. */
+  /*! The sampler factory precomputes samples for usage by multiple
+   *  samlper threads. Samples are precomputed for chunks of
+   *  consecutive iterations, such that accumulation iterations inside
+   *  a chunk only select a different range of the chunk. The chunk of
+   *  an upcoming iteration can be prepared ahead of time by threads
+   *  that are idle at the end of the current frame. */
   class SamplerFactory : public RefCount 
   {
     friend class Sampler;
@@ -139,15 +146,77 @@ namespace embree
     /*! Request a precomputed light sample. */
     int requestLightSample(int baseSample, const Ref<Light>& light);
 
-    /*! Reset the sampler factory. Delete all precomputed samples. */
+    /*! Reset the sampler factory. Forgets all requests, precomputed
+     *  samples are kept for reuse if the same requests follow. */
     void reset();
 
-    /*! Initialize the factory for a given iteration and precompute all samples. */
-    void init(int iteration = 0, const Ref<Filter> filter = NULL);
+    /*! Initialize the factory for a given iteration and precompute
+     *  all samples in parallel, unless the samples of the iteration
+     *  are precomputed already for the current requests. The samples
+     *  of the iteration start at sampleOffset in the sample sequence,
+     *  which defaults to iteration*samplesPerPixel. */
+    virtual void init(int iteration = 0, const Ref<Filter> filter = NULL, int sampleOffset = -1);
+
+    /*! Starts preparing the samples of a future iteration. The
+     *  samples get generated by threads calling prepareSets. */
+    void prepare(int iteration);
+
+    /*! Generates sample sets of the prepared iteration until none are left. */
+    void prepareSets();
+
+    /*! Returns true if samples are generated on the fly with generate
+     *  instead of being read from the precomputed sample sets. */
+    virtual bool procedural() const { return false; }
+
+    /*! Generates sample s of pixel (x,y) into a sample allocated with allocate. */
+    virtual void generate(int x, int y, int s, PrecomputedSample& sample) const {}
+
+    /*! Allocates the additional sample arrays of a sample. */
+    void allocate(PrecomputedSample& sample) const;
+
+    /*! Frees the additional sample arrays of a sample. */
+    void deallocate(PrecomputedSample& sample) const;
 
     /*! Create a sampler thread using this factory. */
     Sampler* create();
 
+  private:
+
+    /*! Precomputed sample sets for a chunk of consecutive iterations. */
+    struct Chunk
+    {
+      Chunk () : id(-1), size(0), numSamples1D(0), numSamples2D(0), sets(NULL) {}
+
+      int id;                             //!< Index of the chunk, -1 if empty.
+      int size;                           //!< Number of samples per set.
+      int numSamples1D;                   //!< Number of additional 1D samples the chunk was generated for.
+      int numSamples2D;                   //!< Number of additional 2D samples the chunk was generated for.
+      std::vector<Ref<Light> > lights;    //!< Light sources the chunk was generated for.
+      std::vector<int> lightBaseSamples;  //!< Base samples of the light samples.
+      Ref<Filter> filter;                 //!< Pixel filter the chunk was generated for.
+      PrecomputedSample** sets;           //!< Sample sets of the chunk.
+      Atomic nextSet;                     //!< Next set to generate during preparation.
+      Atomic doneSets;                    //!< Number of generated sets during preparation.
+    };
+
+    /*! Number of samples per set of a chunk. */
+    int chunkSize() const { return max(samplesPerPixel,64); }
+
+    /*! Tests if a chunk holds chunk id for the current requests. */
+    bool matches(const Chunk* chunk, int id, const Ref<Filter>& filter) const;
+
+    /*! Allocates a chunk for the current requests. */
+    void initChunk(Chunk* chunk, int id, const Ref<Filter>& filter);
+
+    /*! Frees all sample sets of a chunk. */
+    void freeChunk(Chunk* chunk);
+
+    /*! Generates one sample set of a chunk. */
+    void generateSet(Chunk* chunk, int set);
+
+    /*! Generates the sets of the active chunk in parallel. */
+    TASK_RUN_FUNCTION(SamplerFactory,generateSets);
+
   public:
     int numSamples1D;                  //!< Number of additional 1D samples per pixel sample.
     int numSamples2D;                  //!< Number of additional 2D samples per pixel sample.
@@ -157,8 +226,13 @@ namespace embree
 
     int samplesPerPixel;               //!< Number of samples per pixel.
     int sampleSets;                    //!< Number of precomputed sample sets.
-    PrecomputedSample** samples;       //!< All precomputed samples.
+    PrecomputedSample** samples;       //!< Precomputed samples of the current iteration.
     int iteration;                     //!< Current iteration.
+    int sampleOffset;                  //!< Index of the first sample of the current iteration in the sample sequence.
+
+  private:
+    Chunk* active;                     //!< Chunk the samples of the current iteration are taken from.
+    Chunk* next;                       //!< Chunk prepared for a future iteration.
   };
 }
 
@@ -0,0 +1,105 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "samplers/sobolsampler.h"
+
+namespace embree
+{
+  /*! integer hash to derive per pixel and dimension seeds */
+  static __forceinline uint32 hash(uint32 x) {
+    x ^= x >> 16; x *= 0x7feb352d;
+    x ^= x >> 15; x *= 0x846ca68b;
+    x ^= x >> 16;
+    return x;
+  }
+
+  static __forceinline uint32 reverseBits(uint32 x) {
+    x = (x << 16) | (x >> 16);
+    x = ((x & 0x00ff00ff) << 8) | ((x & 0xff00ff00) >> 8);
+    x = ((x & 0x0f0f0f0f) << 4) | ((x & 0xf0f0f0f0) >> 4);
+    x = ((x & 0x33333333) << 2) | ((x & 0xcccccccc) >> 2);
+    x = ((x & 0x55555555) << 1) | ((x & 0xaaaaaaaa) >> 1);
+    return x;
+  }
+
+  /*! Owen scrambling of the bits of x, only higher bits influence lower bits */
+  static __forceinline uint32 owenScramble(uint32 x, uint32 seed) {
+    x = reverseBits(x);
+    x += seed;
+    x ^= x * 0x6c50b47c;
+    x ^= x * 0xb82f1e52;
+    x ^= x * 0xc7afe638;
+    x ^= x * 0x8d22f6e6;
+    return reverseBits(x);
+  }
+
+  /*! second dimension of the Sobol sequence */
+  static __forceinline uint32 sobol1(uint32 index) {
+    uint32 r = 0;
+    for (uint32 v = 1u << 31; index; index >>= 1, v ^= v >> 1)
+      if (index & 1) r ^= v;
+    return r;
+  }
+
+  static __forceinline float toFloat(uint32 x) {
+    return float(x >> 8) * (1.0f/16777216.0f);
+  }
+
+  static __forceinline float sample1D(uint32 index, uint32 seed) {
+    index = owenScramble(index,seed);
+    return toFloat(owenScramble(reverseBits(index),hash(seed^0x5bd1e995)));
+  }
+
+  static __forceinline Vec2f sample2D(uint32 index, uint32 seed) {
+    index = owenScramble(index,seed);
+    return Vec2f(toFloat(owenScramble(reverseBits(index),hash(seed^0x5bd1e995))),
+                 toFloat(owenScramble(sobol1(index)     ,hash(seed^0x68e31da4))));
+  }
+
+  SobolSamplerFactory::SobolSamplerFactory(const Parms& parms)
+    : SamplerFactory(parms) {}
+
+  void SobolSamplerFactory::init(int iteration, const Ref<Filter> filter, int sampleOffset)
+  {
+    this->iteration = iteration;
+    this->sampleOffset = sampleOffset < 0 ? iteration*samplesPerPixel : sampleOffset;
+    this->filter = filter;
+  }
+
+  void SobolSamplerFactory::generate(int x, int y, int s, PrecomputedSample& sample) const
+  {
+    const uint32 index = uint32(sampleOffset + s);
+    const uint32 seed  = hash(uint32(x) + hash(uint32(y)));
+
+    /*! pixel, lens, and time samples use dimensions 0 to 2 */
+    sample.pixel = sample2D(index,hash(seed+0));
+    sample.lens  = sample2D(index,hash(seed+1));
+    sample.time  = sample1D(index,hash(seed+2));
+    if (filter) sample.pixel = filter->sample(sample.pixel) + Vec2f(0.5f, 0.5f);
+
+    /*! followed by the additional samples requested by the integrator */
+    uint32 dim = 3;
+    for (int d = 0; d < numSamples1D; d++) sample.samples1D[d] = sample1D(index,hash(seed+dim++));
+    for (int d = 0; d < numSamples2D; d++) sample.samples2D[d] = sample2D(index,hash(seed+dim++));
+
+    /*! light samples reuse the 2D samples they are based on */
+    for (int d = 0; d < numLightSamples; d++) {
+      LightSample& ls = sample.lightSamples[d];
+      DifferentialGeometry dg;
+      ls.L = lights[d]->sample(dg, ls.wi, ls.tMax, sample.samples2D[lightBaseSamples[d]]);
+    }
+  }
+}
@@ -0,0 +1,51 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#ifndef __EMBREE_SOBOL_SAMPLER_H__
+#define __EMBREE_SOBOL_SAMPLER_H__
+
+#include "samplers/sampler.h"
+
+namespace embree
+{
+  /*! Sampler factory that generates samples on the fly instead of
+   *  precomputing sample sets. Each sample is drawn from the first two
+   *  dimensions of the Sobol sequence with hash based Owen scrambling,
+   *  and the sample index is shuffled per pixel and dimension to
+   *  decorrelate dimensions. Supports any number of samples per pixel
+   *  and continues the sequence over accumulated iterations. */
+  class SobolSamplerFactory : public SamplerFactory
+  {
+  public:
+    /*! Construction from parameters. */
+    SobolSamplerFactory(const Parms& parms);
+
+    /*! Initialize the factory for a given iteration, nothing gets precomputed. */
+    void init(int iteration = 0, const Ref<Filter> filter = NULL, int sampleOffset = -1);
+
+    /*! Samples are generated on the fly. */
+    bool procedural() const { return true; }
+
+    /*! Generates sample s of pixel (x,y) for the current iteration,
+     *  which is sample sampleOffset+s of the sequence of the pixel. */
+    void generate(int x, int y, int s, PrecomputedSample& sample) const;
+
+  private:
+    Ref<Filter> filter;  //!< Pixel filter to warp pixel samples with.
+  };
+}
+
+#endif
@@ -18,6 +18,7 @@
 #define __EMBREE_DIFFERENTIAL_GEOMETRY_H__
 
 #include "default.h" 
+#include "renderers/ray.h"
 
 namespace embree
 {
@@ -28,7 +29,32 @@ namespace embree
   {
     /*! Default construction. */
     __forceinline DifferentialGeometry()
-      : material(NULL), light(NULL) {}
+      : material(NULL), light(NULL), dstdx(zero), dstdy(zero) {}
+
+    /*! Computes the texture space footprint of a pixel from the ray
+     *  differentials. dPdu and dPdv span the tangent plane of the
+     *  hit, dstdu and dstdv are the texture coordinate derivatives
+     *  along these directions. */
+    __forceinline void setTextureDifferentials(const Ray& ray, const Vector3f& dPdu, const Vector3f& dPdv, const Vec2f& dstdu, const Vec2f& dstdv)
+    {
+      /* secondary rays carry no differentials */
+      if (ray.dDdx == Vector3f(zero) && ray.dDdy == Vector3f(zero)) return;
+
+      const Vector3f N = cross(dPdu,dPdv);
+      const float DdotN = dot(Vector3f(ray.dir),N), NdotN = dot(N,N);
+      if (DdotN == 0.0f || NdotN == 0.0f) return;
+
+      /* transfer the differentials to the tangent plane */
+      const Vector3f dPdx = ray.tfar*(Vector3f(ray.dDdx) - dot(Vector3f(ray.dDdx),N)*rcp(DdotN)*Vector3f(ray.dir));
+      const Vector3f dPdy = ray.tfar*(Vector3f(ray.dDdy) - dot(Vector3f(ray.dDdy),N)*rcp(DdotN)*Vector3f(ray.dir));
+
+      /* express them in the dPdu, dPdv basis */
+      const float rcpNdotN = rcp(NdotN);
+      const float dudx = dot(cross(dPdx,dPdv),N)*rcpNdotN, dvdx = dot(cross(dPdu,dPdx),N)*rcpNdotN;
+      const float dudy = dot(cross(dPdy,dPdv),N)*rcpNdotN, dvdy = dot(cross(dPdu,dPdy),N)*rcpNdotN;
+      dstdx = dudx*dstdu + dvdx*dstdv;
+      dstdy = dudy*dstdu + dvdy*dstdv;
+    }
 
   public:
     class Material*  material; //!< pointer to material of hit shape instance
@@ -41,6 +67,8 @@ namespace embree
     Vector3f Ng;               //!< Normalized geometry normal.
     mutable Vector3f Ns;       //!< Normalized shading normal.
     Vec2f st;                  //!< Hit location in surface parameter space.
+    Vec2f dstdx;               //!< Derivative of st with respect to the raster x coordinate.
+    Vec2f dstdy;               //!< Derivative of st with respect to the raster y coordinate.
     float error;               //!< Intersection error factor.
     light_mask_t illumMask;    //!< bit mask which light we're interested in
     light_mask_t shadowMask;   //!< bit mask which light we're interested in
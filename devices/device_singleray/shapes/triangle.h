@@ -78,6 +78,7 @@ namespace embree
       dg.Ng = this->Ng;
       dg.Ns = this->Ng;
       dg.st = Vec2f(ray.u,ray.v);
+      dg.setTextureDifferentials(ray,v1-v0,v2-v0,Vec2f(1.0f,0.0f),Vec2f(0.0f,1.0f));
       dg.error = max(abs(ray.tfar),reduce_max(abs(dg.P)));
     }
 
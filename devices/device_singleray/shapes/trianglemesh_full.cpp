@@ -176,6 +176,7 @@ namespace embree
       dsdu = 1; dtdu = 0;
       dsdv = 0; dtdv = 1;
     }
+    dg.setTextureDifferentials(ray,dPdu,dPdv,Vec2f(dsdu,dtdu),Vec2f(dsdv,dtdv));
 
     /* interpolate shading normal */
     if (normal.size())
@@ -0,0 +1,211 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#ifndef __EMBREE_MIPMAP_H__
+#define __EMBREE_MIPMAP_H__
+
+#include "image/image.h"
+#include "image/compressed.h"
+#include "../textures/texture.h"
+
+namespace embree
+{
+  /*! Implements an image mapped texture with a mip-map pyramid that
+   *  gets built at construction. Lookups select the level from the
+   *  texture space footprint and filter bilinearly in that level or
+   *  trilinearly between the two closest levels. Low dynamic range
+   *  images keep 8 bit texels to stay small in the caches, and
+   *  compressed images keep their storage format in all levels. */
+  class MipMap : public Texture
+  {
+    /*! Location of one level of the pyramid. */
+    struct Level
+    {
+      Level (size_t width, size_t height, size_t offset)
+        : width(width), height(height), offset(offset) {}
+
+      size_t width, height; //!< size of the level in texels
+      size_t offset;        //!< offset of the first texel of the level
+    };
+
+    /*! Storage format of the levels. */
+    enum Format { LDR, HDR, BC1, RGB9E5, HALF };
+
+    /*! Accesses texels of the uncompressed texel arrays. */
+    template<typename T> struct Texels 
+    {
+      __forceinline Texels (const std::vector<T>& texels, const std::vector<Level>& levels) 
+        : texels(&texels[0]), levels(levels) {}
+
+      __forceinline size_t width (size_t level) const { return levels[level].width; }
+      __forceinline size_t height(size_t level) const { return levels[level].height; }
+
+      __forceinline void add(Col4f& c, size_t level, size_t x, size_t y, const float w) const {
+        addTexel(c,texels[levels[level].offset+y*levels[level].width+x],w);
+      }
+
+      const T* texels;
+      const std::vector<Level>& levels;
+    };
+
+    /*! Accesses texels of compressed level images without virtual calls. */
+    template<typename I> struct Images 
+    {
+      __forceinline Images (const std::vector<Ref<Image> >& images) : images(images) {}
+
+      __forceinline size_t width (size_t level) const { return images[level]->width; }
+      __forceinline size_t height(size_t level) const { return images[level]->height; }
+
+      __forceinline void add(Col4f& c, size_t level, size_t x, size_t y, const float w) const {
+        const Color4 t = ((const I*)images[level].ptr)->I::get(x,y);
+        c.r += w*t.r; c.g += w*t.g; c.b += w*t.b; c.a += w*t.a;
+      }
+
+      const std::vector<Ref<Image> >& images;
+    };
+
+  public:
+
+    /*! Construction from parameters. */
+    MipMap (const Parms& parms)
+    {
+      const std::string filter = parms.getString("filter","trilinear");
+      if      (filter == "bilinear" ) trilinear = false;
+      else if (filter == "trilinear") trilinear = true;
+      else throw std::runtime_error("unknown mipmap filter: "+filter);
+
+      Ref<Image> image = parms.getImage("image");
+      if (!image) throw std::runtime_error("mipmap texture has no image");
+      if      (dynamic_cast<ImageBC1*   >(image.ptr)) format = BC1;
+      else if (dynamic_cast<ImageRGB9E5*>(image.ptr)) format = RGB9E5;
+      else if (dynamic_cast<ImageHalf*  >(image.ptr)) format = HALF;
+      else if (dynamic_cast<Image3c*>(image.ptr) || dynamic_cast<Image4c*>(image.ptr)) format = LDR;
+      else format = HDR;
+      build(image);
+    }
+
+    Color4 get(const Vec2f& p) const {
+      return lookup(p,0.0f);
+    }
+
+    Color4 get(const Vec2f& p, const Vec2f& dpdx, const Vec2f& dpdy) const
+    {
+      /* squared footprint in texels of the finest level */
+      const float w = float(width), h = float(height);
+      const float lx = sqr(dpdx.x*w) + sqr(dpdx.y*h);
+      const float ly = sqr(dpdy.x*w) + sqr(dpdy.y*h);
+      const float l = max(lx,ly);
+      if (l <= 1.0f) return lookup(p,0.0f);
+      return lookup(p,min(0.5f*1.44269504f*logf(l),float(numLevels-1))); // 0.5*log2(l)
+    }
+
+  private:
+
+    /*! Dispatches a lookup to the storage format. */
+    __forceinline Color4 lookup(const Vec2f& p, const float lod) const
+    {
+      switch (format) {
+      case LDR   : return filter(Texels<Col4c>(ldr,levels),p,lod);
+      case HDR   : return filter(Texels<Col4f>(hdr,levels),p,lod);
+      case BC1   : return filter(Images<ImageBC1>(images),p,lod);
+      case RGB9E5: return filter(Images<ImageRGB9E5>(images),p,lod);
+      default    : return filter(Images<ImageHalf>(images),p,lod);
+      }
+    }
+
+    /*! Builds all levels of the pyramid by repeated 2x2 box filtering. */
+    void build(const Ref<Image>& image)
+    {
+      width = image->width; height = image->height;
+      size_t w = width, h = height;
+      std::vector<Col4f> src(w*h,Col4f(zero));
+      for (size_t y=0; y<h; y++)
+        for (size_t x=0; x<w; x++)
+          image->get(x,y).set(src[y*w+x]);
+
+      size_t size = 0;
+      for (size_t lw=w, lh=h;; lw=max(lw/2,size_t(1)), lh=max(lh/2,size_t(1))) {
+        levels.push_back(Level(lw,lh,size)); size += lw*lh;
+        if (lw == 1 && lh == 1) break;
+      }
+      numLevels = levels.size();
+      store(src,levels[0],size);
+
+      for (size_t i=1; i<levels.size(); i++)
+      {
+        const Level& l = levels[i];
+        std::vector<Col4f> dst(l.width*l.height,Col4f(zero));
+        downsample2x2(&src[0],w,h,&dst[0],l.width,l.height);
+        store(dst,l,size);
+        src.swap(dst); w = l.width; h = l.height;
+      }
+    }
+
+    /*! Stores a filtered level in the storage format. 8 bit texels
+     *  are rounded to avoid darkening the coarser levels. */
+    void store(const std::vector<Col4f>& src, const Level& l, size_t size)
+    {
+      switch (format) {
+      case LDR:
+        ldr.resize(size,Col4c(zero));
+        for (size_t i=0; i<l.width*l.height; i++) {
+          const Col4f& c = src[i];
+          ldr[l.offset+i] = Col4c((unsigned char)(clamp(c.r)*255.0f+0.5f),(unsigned char)(clamp(c.g)*255.0f+0.5f),
+                                  (unsigned char)(clamp(c.b)*255.0f+0.5f),(unsigned char)(clamp(c.a)*255.0f+0.5f));
+        }
+        break;
+      case HDR:
+        hdr.resize(size,Col4f(zero));
+        for (size_t i=0; i<l.width*l.height; i++) hdr[l.offset+i] = src[i];
+        break;
+      default: {
+        const char* compression = format == BC1 ? "bc1" : format == RGB9E5 ? "rgb9e5" : "half";
+        images.push_back(compressImage(new Image4f(l.width,l.height,(Col4f*)&src[0]),compression));
+      }
+      }
+    }
+
+    /*! Filtered lookup at a fractional level of detail. */
+    template<typename Access> __forceinline Color4 filter(const Access& a, const Vec2f& p, const float lod) const
+    {
+      Col4f c(zero);
+      if (!trilinear) {
+        bilinearRepeat(a,size_t(lod+0.5f),p,1.0f,c);
+        return Color4(c);
+      }
+      const size_t i = size_t(lod);
+      const float f = lod-float(i);
+      if (i+1 >= numLevels || f == 0.0f) bilinearRepeat(a,i,p,1.0f,c);
+      else {
+        bilinearRepeat(a,i+0,p,1.0f-f,c);
+        bilinearRepeat(a,i+1,p,f,c);
+      }
+      return Color4(c);
+    }
+
+  protected:
+    bool trilinear;                  //!< blend between the two closest levels
+    Format format;                   //!< storage format of the levels
+    size_t width, height;            //!< size of the finest level
+    size_t numLevels;                //!< number of levels
+    std::vector<Level> levels;       //!< levels from finest to coarsest
+    std::vector<Col4c> ldr;          //!< texels of all levels for low dynamic range images
+    std::vector<Col4f> hdr;          //!< texels of all levels for high dynamic range images
+    std::vector<Ref<Image> > images; //!< levels of compressed images
+  };
+}
+
+#endif
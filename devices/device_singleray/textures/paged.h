@@ -0,0 +1,124 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#ifndef __EMBREE_PAGED_H__
+#define __EMBREE_PAGED_H__
+
+#include "../textures/texture.h"
+#include "../textures/tilecache.h"
+
+namespace embree
+{
+  /*! Implements a texture that reads the tiles of a tiled, mip-mapped
+   *  image file (.etx) on demand through the tile cache. Filtering
+   *  matches the MipMap texture, but only the tiles that are actually
+   *  accessed get loaded. */
+  class Paged : public Texture
+  {
+  public:
+
+    /*! Construction from parameters. */
+    Paged (const Parms& parms)
+      : cache(TileCache::instance())
+    {
+      const std::string filter = parms.getString("filter","trilinear");
+      if      (filter == "bilinear" ) trilinear = false;
+      else if (filter == "trilinear") trilinear = true;
+      else throw std::runtime_error("unknown paged texture filter: "+filter);
+
+      image = new TiledImage(parms.getString("file"));
+      imageID = cache.newImageID();
+      tileShift = 0; while ((size_t(1) << tileShift) < image->tileSize) tileShift++;
+      if ((size_t(1) << tileShift) != image->tileSize) 
+        throw std::runtime_error(image->fileName.str() + ": tile size has to be a power of two");
+    }
+
+    Color4 get(const Vec2f& p) const {
+      if (image->hdr) return bilinear<Col4f>(0,p);
+      else            return bilinear<Col4c>(0,p);
+    }
+
+    Color4 get(const Vec2f& p, const Vec2f& dpdx, const Vec2f& dpdy) const
+    {
+      /* squared footprint in texels of the finest level */
+      const float w = float(image->levels[0].width), h = float(image->levels[0].height);
+      const float lx = sqr(dpdx.x*w) + sqr(dpdx.y*h);
+      const float ly = sqr(dpdy.x*w) + sqr(dpdy.y*h);
+      const float l = max(lx,ly);
+      if (l <= 1.0f) return get(p);
+
+      const float lod = min(0.5f*1.44269504f*logf(l),float(image->levels.size()-1)); // 0.5*log2(l)
+      if (image->hdr) return filter<Col4f>(p,lod);
+      else            return filter<Col4c>(p,lod);
+    }
+
+  private:
+
+    /*! Returns a texel of a level through the tile cache. */
+    template<typename T> __forceinline const T& texel(size_t level, size_t x, size_t y) const {
+      const size_t mask = image->tileSize-1;
+      const T* tile = (const T*) cache.lookup(image.ptr,imageID,level,x >> tileShift,y >> tileShift);
+      return tile[((y & mask) << tileShift) + (x & mask)];
+    }
+
+    /*! Accesses texels of the levels through the tile cache. */
+    template<typename T> struct Tiles
+    {
+      __forceinline Tiles (const Paged* paged) : paged(paged) {}
+
+      __forceinline size_t width (size_t level) const { return paged->image->levels[level].width; }
+      __forceinline size_t height(size_t level) const { return paged->image->levels[level].height; }
+
+      __forceinline void add(Col4f& c, size_t level, size_t x, size_t y, const float w) const {
+        addTexel(c,paged->texel<T>(level,x,y),w);
+      }
+
+      const Paged* paged;
+    };
+
+    /*! Bilinear lookup with repeat addressing into one level. */
+    template<typename T> __forceinline void bilinear(size_t level, const Vec2f& p, const float w, Col4f& c) const {
+      bilinearRepeat(Tiles<T>(this),level,p,w,c);
+    }
+
+    template<typename T> __forceinline Color4 bilinear(size_t level, const Vec2f& p) const {
+      Col4f c(zero); bilinear<T>(level,p,1.0f,c);
+      return Color4(c);
+    }
+
+    /*! Filtered lookup at a fractional level of detail. */
+    template<typename T> __forceinline Color4 filter(const Vec2f& p, const float lod) const
+    {
+      if (!trilinear) return bilinear<T>(size_t(lod+0.5f),p);
+      const size_t i = size_t(lod);
+      if (i+1 >= image->levels.size()) return bilinear<T>(i,p);
+      const float f = lod-float(i);
+      Col4f c(zero);
+      bilinear<T>(i+0,p,1.0f-f,c);
+      bilinear<T>(i+1,p,f,c);
+      return Color4(c);
+    }
+
+  protected:
+    TileCache& cache;          //!< cache the tiles are read through
+    Ref<TiledImage> image;     //!< tiled image file
+    size_t imageID;            //!< identifies the tiles of this image in the cache
+    size_t tileShift;          //!< log2 of the tile size
+    bool trilinear;            //!< blend between the two closest levels
+  };
+}
+
+#endif
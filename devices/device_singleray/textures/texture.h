@@ -33,7 +33,44 @@ namespace embree
     /*! Returns the color for a surface point p. \param p is the
      *  location to query the color for. The range is 0 to 1. */
     virtual Color4 get(const Vec2f& p) const = 0;
+
+    /*! Returns the color for a surface point p filtered over the
+     *  footprint spanned by the texture space derivatives dpdx and
+     *  dpdy. Textures without prefiltering return a point sample. */
+    virtual Color4 get(const Vec2f& p, const Vec2f& dpdx, const Vec2f& dpdy) const { return get(p); }
   };
+
+  /*! Adds a weighted texel to a filter result. */
+  __forceinline void addTexel(Col4f& c, const Col4f& t, const float w) {
+    c.r += w*t.r; c.g += w*t.g; c.b += w*t.b; c.a += w*t.a;
+  }
+
+  __forceinline void addTexel(Col4f& c, const Col4c& t, float w) {
+    w *= one_over_255; c.r += w*float(t.r); c.g += w*float(t.g); c.b += w*float(t.b); c.a += w*float(t.a);
+  }
+
+  /*! Bilinear lookup with repeat addressing into one level of a
+   *  texture. The accessor provides the size of the level and adds
+   *  weighted texels of the level to the filter result. */
+  template<typename Access> __forceinline void bilinearRepeat(const Access& a, size_t level, const Vec2f& p, const float w, Col4f& c)
+  {
+    const int width = int(a.width(level)), height = int(a.height(level));
+    const float x = (p.x-floor(p.x))*float(width )-0.5f;
+    const float y = (p.y-floor(p.y))*float(height)-0.5f;
+    const float fx = floor(x), fy = floor(y);
+    const float sx = x-fx, sy = y-fy;
+
+    int x0 = int(fx), x1 = x0+1, y0 = int(fy), y1 = y0+1;
+    if (x0 < 0) x0 += width;
+    if (x1 >= width) x1 -= width;
+    if (y0 < 0) y0 += height;
+    if (y1 >= height) y1 -= height;
+
+    a.add(c,level,x0,y0,w*(1.0f-sx)*(1.0f-sy));
+    a.add(c,level,x1,y0,w*sx*(1.0f-sy));
+    a.add(c,level,x0,y1,w*(1.0f-sx)*sy);
+    a.add(c,level,x1,y1,w*sx*sy);
+  }
 }
 
 #endif
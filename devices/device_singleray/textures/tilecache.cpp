@@ -0,0 +1,136 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "tilecache.h"
+
+#include <iostream>
+#include <sstream>
+#include <cstring>
+
+namespace embree
+{
+  /*! never destroyed, as threads may still hold tiles at exit */
+  TileCache& TileCache::instance() {
+    static TileCache* cache = new TileCache;
+    return *cache;
+  }
+
+  TileCache::TileCache ()
+    : tls(createTls()), generation(0), bytes(0), maxBytes(size_t(1024)*1024*1024), sharedHits(0), loads(0), evictions(0) {}
+
+  TileCache::ThreadCache* TileCache::threadCache()
+  {
+    ThreadCache* cache = (ThreadCache*) getTls(tls);
+    if (likely(cache != NULL)) return cache;
+    Lock<MutexSys> lock(mutex);
+    cache = new ThreadCache(generation);
+    threadCaches.push_back(cache);
+    setTls(tls,cache);
+    return cache;
+  }
+
+  const void* TileCache::miss(ThreadCache* cache, size_t slot, uint64 key, TiledImage* image, size_t level, size_t tx, size_t ty)
+  {
+    if (cache->generation != generation) cache->flush(generation);
+    cache->misses++;
+
+    /* look into the shared cache */
+    Ref<TextureTile> tile;
+    {
+      Lock<MutexSys> lock(mutex);
+      std::map<uint64,Entry>::iterator i = entries.find(key);
+      if (i != entries.end()) {
+        lru.splice(lru.begin(),lru,i->second.lru);
+        tile = i->second.tile;
+        sharedHits++;
+      }
+    }
+
+    /* read the tile without holding the lock */
+    if (!tile) 
+    {
+      tile = new TextureTile(image->tileBytes());
+      try { 
+        image->readTile(level,tx,ty,tile->data); 
+      } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        memset(tile->data,0,tile->bytes);
+      }
+
+      Lock<MutexSys> lock(mutex);
+      std::map<uint64,Entry>::iterator i = entries.find(key);
+      if (i != entries.end()) tile = i->second.tile; // another thread was faster
+      else {
+        lru.push_front(key);
+        Entry& entry = entries[key];
+        entry.tile = tile;
+        entry.lru = lru.begin();
+        bytes += tile->bytes;
+        loads++;
+        evict();
+      }
+    }
+
+    cache->keys[slot] = key;
+    cache->tiles[slot] = tile;
+    return tile->data;
+  }
+
+  void TileCache::evict()
+  {
+    while (bytes > maxBytes && !lru.empty()) {
+      std::map<uint64,Entry>::iterator i = entries.find(lru.back());
+      bytes -= i->second.tile->bytes;
+      entries.erase(i);
+      lru.pop_back();
+      evictions++;
+    }
+  }
+
+  void TileCache::setMaxBytes(size_t bytes) 
+  {
+    Lock<MutexSys> lock(mutex);
+    maxBytes = bytes;
+    evict();
+  }
+
+  void TileCache::clear() 
+  {
+    Lock<MutexSys> lock(mutex);
+    entries.clear(); lru.clear(); bytes = 0;
+    generation++;
+  }
+
+  bool TileCache::printStatistics(std::ostream& cout)
+  {
+    Lock<MutexSys> lock(mutex);
+    size_t hits = 0, misses = 0;
+    for (size_t i=0; i<threadCaches.size(); i++) {
+      hits += threadCaches[i]->hits;
+      misses += threadCaches[i]->misses;
+    }
+    if (hits+misses == 0) return false;
+
+    std::ostringstream stream;
+    stream.setf(std::ios::fixed, std::ios::floatfield);
+    stream.precision(2);
+    stream << "texcache " << 100.0*double(hits+sharedHits)/double(hits+misses) << "% hits, ";
+    stream << loads << " tiles read, " << evictions << " evicted, ";
+    stream << double(bytes)*1E-6 << " of " << double(maxBytes)*1E-6 << " MB";
+    cout << stream.str() << std::endl;
+    return true;
+  }
+}
@@ -0,0 +1,128 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#ifndef __EMBREE_TILE_CACHE_H__
+#define __EMBREE_TILE_CACHE_H__
+
+#include "image/tiled.h"
+#include "sys/thread.h"
+#include "sys/sync/mutex.h"
+#include "sys/sync/atomic.h"
+
+#include <map>
+#include <list>
+
+namespace embree
+{
+  /*! Tile of a tiled image that is resident in the tile cache. */
+  class TextureTile : public RefCount
+  {
+  public:
+    TextureTile (size_t bytes) : data(alignedMalloc(bytes)), bytes(bytes) {}
+    ~TextureTile () { alignedFree(data); }
+  public:
+    void* data;    //!< texels of the tile
+    size_t bytes;  //!< size of the texel data
+  };
+
+  /*! Cache of texture tiles shared by all paged textures. Tiles get
+   *  read on demand and are evicted in least recently used order when
+   *  the cache exceeds its byte budget. Each thread keeps a small
+   *  direct mapped cache of the tiles it used last, which is looked
+   *  up without locking. Only misses there go to the shared cache. */
+  class TileCache
+  {
+    /*! Per thread cache of recently used tiles. Holding a reference
+     *  keeps tiles alive that got evicted from the shared cache. */
+    struct ThreadCache 
+    {
+      enum { SIZE = 64 };
+
+      ThreadCache (size_t generation) : generation(generation), hits(0), misses(0) { 
+        for (size_t i=0; i<SIZE; i++) keys[i] = uint64(-1);
+      }
+
+      void flush(size_t generation) {
+        for (size_t i=0; i<SIZE; i++) { keys[i] = uint64(-1); tiles[i] = null; }
+        this->generation = generation;
+      }
+
+      uint64 keys[SIZE];               //!< keys of the cached tiles
+      Ref<TextureTile> tiles[SIZE];    //!< cached tiles
+      size_t generation;               //!< generation of the shared cache the tiles belong to
+      size_t hits, misses;             //!< statistics, only written by the owning thread
+    };
+
+    /*! Entry of the shared cache. */
+    struct Entry {
+      Ref<TextureTile> tile;           //!< resident tile
+      std::list<uint64>::iterator lru; //!< position in LRU list
+    };
+
+  public:
+
+    /*! Returns the cache used by all paged textures. */
+    static TileCache& instance();
+
+    /*! Returns a new ID to identify the tiles of an image. */
+    size_t newImageID() { return imageIDs++; }
+
+    /*! Returns the texels of a tile of an image, reading it if not resident. */
+    __forceinline const void* lookup(TiledImage* image, size_t imageID, size_t level, size_t tx, size_t ty)
+    {
+      ThreadCache* cache = threadCache();
+      const uint64 key = (uint64(imageID) << 40) | (uint64(level) << 34) | (uint64(ty) << 17) | uint64(tx);
+      const size_t slot = (tx ^ (ty*5) ^ (level*17) ^ (imageID*31)) & (ThreadCache::SIZE-1);
+      if (likely(cache->keys[slot] == key && cache->generation == generation)) {
+        cache->hits++;
+        return cache->tiles[slot]->data;
+      }
+      return miss(cache,slot,key,image,level,tx,ty);
+    }
+
+    /*! Sets the byte budget of the cache. */
+    void setMaxBytes(size_t bytes);
+
+    /*! Removes all tiles from the cache. */
+    void clear();
+
+    /*! Prints hit and miss statistics, returns false if the cache was never used. */
+    bool printStatistics(std::ostream& cout);
+
+  private:
+    TileCache ();
+    ThreadCache* threadCache();
+    const void* miss(ThreadCache* cache, size_t slot, uint64 key, TiledImage* image, size_t level, size_t tx, size_t ty);
+    void evict();
+
+  private:
+    tls_t tls;                                //!< per thread caches
+    volatile size_t generation;               //!< incremented when the cache gets cleared
+    Atomic imageIDs;                          //!< counter for image IDs
+
+    MutexSys mutex;                           //!< protects the shared cache
+    std::vector<ThreadCache*> threadCaches;   //!< all per thread caches
+    std::map<uint64,Entry> entries;           //!< resident tiles by key
+    std::list<uint64> lru;                    //!< keys, most recently used first
+    size_t bytes;                             //!< bytes of all resident tiles
+    size_t maxBytes;                          //!< byte budget of the cache
+    size_t sharedHits;                        //!< tiles found in the shared cache
+    size_t loads;                             //!< tiles read from disk
+    size_t evictions;                         //!< tiles evicted from the shared cache
+  };
+}
+
+#endif
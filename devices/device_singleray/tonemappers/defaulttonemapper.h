@@ -50,6 +50,34 @@ namespace embree
       return color0;
     }
 
+    /*! Evaluates the tonemapper for a row, performs gamma correction 4 pixels at a time. */
+    virtual void evalRow (float* r, float* g, float* b, const size_t n, const int x, const int y, const Ref<SwapChain>& swapchain) const
+    {
+      if (unlikely(vignetting)) {
+        ToneMapper::evalRow(r,g,b,n,x,y,swapchain);
+        return;
+      }
+      if (likely(gamma == 1.0f)) return;
+
+      size_t i=0;
+      for (; i+4<=n; i+=4) {
+        _mm_storeu_ps(r+i,gammaCorrect(_mm_loadu_ps(r+i)));
+        _mm_storeu_ps(g+i,gammaCorrect(_mm_loadu_ps(g+i)));
+        _mm_storeu_ps(b+i,gammaCorrect(_mm_loadu_ps(b+i)));
+      }
+      for (; i<n; i++) {
+        const Color c = pow(Color(r[i],g[i],b[i]),rcpGamma);
+        r[i] = c.r; g[i] = c.g; b[i] = c.b;
+      }
+    }
+
+  private:
+
+    /*! Applies the gamma curve to 4 values, non-positive values map to zero. */
+    __forceinline ssef gammaCorrect(const ssef& c) const {
+      return select(c > ssef(zero),pow(c,ssef(rcpGamma)),ssef(zero));
+    }
+
   protected:
     float gamma;     //!< Gamma value
     float rcpGamma;  //!< Reciprocal gamma value.
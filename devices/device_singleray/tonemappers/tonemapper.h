@@ -32,6 +32,15 @@ namespace embree
 
     /*! Evaluates the tonemapper, */
     virtual Color eval (const Color& color, const int x, const int y, const Ref<SwapChain>& swapchain) const = 0;
+
+    /*! Evaluates the tonemapper in place for n consecutive pixels of a row starting at (x,y). */
+    virtual void evalRow (float* r, float* g, float* b, const size_t n, const int x, const int y, const Ref<SwapChain>& swapchain) const
+    {
+      for (size_t i=0; i<n; i++) {
+        const Color c = eval(Color(r[i],g[i],b[i]),x+int(i),y,swapchain);
+        r[i] = c.r; g[i] = c.g; b[i] = c.b;
+      }
+    }
   };
 }
 
@@ -46,7 +46,10 @@ namespace embree
   extern Vector3f g_camUp;
   extern float g_camFieldOfView;
   extern float g_camRadius;
+  extern bool g_camDistortion;
+  extern bool g_stereoSinglePass;
   Handle<Device::RTCamera> createCamera(const AffineSpace3f& space, int stereoType = 0, float stereoDistance = 0.0f, int stereoPixelMargin = 0, float aspectRatio = 1.0);
+  Handle<Device::RTCamera> createStereoCamera(const AffineSpace3f& space, float stereoDistance, float aspectRatio);
   void clearGlobalObjects();
 
   // @syoyo
@@ -71,6 +74,12 @@ namespace embree
   extern size_t g_width, g_height;
   extern std::string g_format;
   extern int g_numBuffers;
+  extern float g_frameBudget;
+
+  /* render resolution relative to the window, lowered to hold the frame budget */
+  static float g_renderScale = 1.0f;
+  static size_t g_renderWidth = 0, g_renderHeight = 0;
+  static double g_renderTime = 0.0; // in ms
 
   /* rendering device and global handles */
   extern Device *g_device;
@@ -262,12 +271,14 @@ namespace embree
   UpdateTex(
     GLuint texID,
     unsigned char* rgb,
-    int w, int h)
+    int w, int h,
+    int rowLength = 0) // in pixels, 0 if rows are w pixels long
   {
     glActiveTexture(GL_TEXTURE0);
     glEnable(GL_TEXTURE_2D);
     glBindTexture(GL_TEXTURE_2D, texID);
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, rowLength);
 #ifdef __linux__
     GLuint fmt = GL_RGBA;
 #else
@@ -276,6 +287,7 @@ namespace embree
     printf("w, h = %d, %d\n", w, h);
     glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, w, h, fmt, GL_UNSIGNED_BYTE, rgb);
     CheckGLErrors("glTexSubImage2D");
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
     
   }
 
@@ -466,6 +478,20 @@ namespace embree
     //config.renderToTexID = GenDummyTex(config.width + config.stereoMargin, config.height); 
   }
 
+  static void
+  ResizeRenderToTexture(
+    RenderConfig& config,
+    int width, int height) // render resolution of one eye
+  {
+    for (int i = 0; i < 2; i++) {
+      glBindTexture(GL_TEXTURE_2D, config.renderToTexID[i]);
+      CheckGLErrors("glBindTextures");
+
+      glTexImage2D(GL_TEXTURE_2D, 0,GL_RGBA8, width + config.stereoMargin, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, 0);
+      CheckGLErrors("glTexImage2D");
+    }
+  }
+
   static bool
   PostProcessRender(
     const RenderConfig& config,
@@ -1179,46 +1205,135 @@ namespace embree
   /*                                   Window control                                              */
   /*************************************************************************************************/
 
+  /*! recreates the framebuffers and render textures when the render resolution changed, the
+   *  textures get bilinearly upscaled to the window by the post process pass. The renderer keeps
+   *  its first hit and reprojection caches per framebuffer, thus a resolution change starts
+   *  them over, the hysteresis of updateRenderScale keeps such changes rare. */
+  static void resizeRenderTarget()
+  {
+    const size_t w = max(size_t(2),size_t(g_renderScale*g_width+0.5f));
+    const size_t h = max(size_t(1),size_t(g_renderScale*g_height+0.5f));
+    if (w == g_renderWidth && h == g_renderHeight) return;
+    g_renderWidth = w; g_renderHeight = h;
+
+    if (g_stereoSinglePass) {
+      g_frameBuffer0 = g_device->rtNewFrameBuffer(g_format.c_str(),w,h,g_numBuffers);
+      g_frameBuffer1 = null;
+    } else {
+      g_frameBuffer0 = g_device->rtNewFrameBuffer(g_format.c_str(),w/2+g_stereoPixelMargin,h,g_numBuffers);
+      g_frameBuffer1 = g_device->rtNewFrameBuffer(g_format.c_str(),w/2,h,g_numBuffers);
+    }
+    ResizeRenderToTexture(g_renderConfig, int(w/2), int(h));
+    g_resetAccumulation = true;
+  }
+
+  /*! adapts the render resolution to the frame budget while the camera moves and goes back to
+   *  full resolution for refinement once it stops. The renderer lowers its samples per pixel to
+   *  the budget first, thus the resolution only drops when frames stay over budget. */
+  static void updateRenderScale(bool moving)
+  {
+    static int overBudget = 0;
+    if (!moving) {
+      g_renderScale = 1.0f;
+      overBudget = 0;
+      return;
+    }
+    if (g_renderTime <= 0.0) return;
+
+    const float ratio = g_frameBudget/float(g_renderTime);
+    if (ratio < 0.9f) {
+      if (++overBudget < 2) return;
+    }
+    else {
+      overBudget = 0;
+      if (ratio < 1.3f || g_renderScale == 1.0f) return;
+    }
+
+    /* render time scales with the number of pixels, aim slightly below the budget, in steps of 1/8 */
+    float scale = g_renderScale*sqrtf(0.9f*ratio);
+    scale = floorf(8.0f*scale)/8.0f;
+    g_renderScale = clamp(scale,0.25f,1.0f);
+    overBudget = 0;
+  }
+
   const size_t avgFrames = 4;
   double g_t0 = getSeconds();
   double g_dt[avgFrames] = { 0.0f };
   size_t frameID = 0;
-  
-  void displayFunc(void)
+
+  /*! Frames render asynchronously and display polls for them, thus new input can cancel the
+   *  frame in flight. Two pass stereo renders the right eye once the left one is ready. */
+  static int g_framePass = -1;                  //!< -1 for no frame in flight, 1 while the right eye renders
+  static volatile int g_frameCancel = 0;        //!< cancel token of the frame in flight
+  static bool g_frameDropped = false;           //!< the previous frame got cancelled
+  static int g_frameAccumulate = 0;             //!< accumulation mode of the frame in flight
+  static double g_frameStart = 0.0;             //!< start time of the frame in flight
+  static Handle<Device::RTCamera> g_frameCameraR; //!< right eye camera of a two pass frame
+
+  static Handle<Device::RTFrameBuffer> frameTarget() {
+    return g_framePass == 1 ? g_frameBuffer1 : g_frameBuffer0;
+  }
+
+  /*! cancels the frame in flight and waits for it, called before the render targets change */
+  static void abortFrame()
+  {
+    if (g_framePass < 0) return;
+    g_frameCancel = 1;
+    g_device->rtWaitFrame(frameTarget());
+    g_framePass = -1;
+  }
+
+  static void startFrame()
   {
-    if (g_pause)
-      return;
-    
     /* create random geometry for regression test */
     if (g_regression)
       g_render_scene = createRandomScene(g_device,1,random<int>()%100,random<int>()%1000);
 
+    /* hold the frame budget while the camera moves */
+    if (g_frameBudget > 0.0f) updateRenderScale(g_resetAccumulation);
+    resizeRenderTarget();
+
     /* set accumulation mode */
-    int accumulate = g_resetAccumulation ? 0 : g_refine;
+    g_frameAccumulate = g_resetAccumulation ? 0 : g_refine;
     g_resetAccumulation = false;
-
+    g_frameCancel = 0;
+    g_frameStart = getSeconds();
 
     // @syoyo: SREREO
     float scale = 100.0;
-    Vector3f camPosL = g_camPos + Vector3f(-scale*g_stereoOffset/2.0, 0.0, 0.0);
-    Vector3f camLookAtL = g_camLookAt + Vector3f(-scale*g_stereoOffset/2.0, 0.0, 0.0);
-    AffineSpace3f camSpaceL = AffineSpace3f::lookAtPoint(camPosL, camLookAtL, g_camUp);
-
-    Vector3f camPosR = g_camPos + Vector3f(scale*g_stereoOffset/2.0, 0.0, 0.0);
-    Vector3f camLookAtR = g_camLookAt + Vector3f(scale*g_stereoOffset/2.0, 0.0, 0.0);
-    AffineSpace3f camSpaceR = AffineSpace3f::lookAtPoint(camPosR, camLookAtR, g_camUp);
-
-    /* render image */
-    Handle<Device::RTCamera> cameraL = createCamera(AffineSpace3f(camSpaceL.l, camSpaceL.p), 0, 0, g_stereoPixelMargin, 0.5f*g_width/(float)g_height);
-    Handle<Device::RTCamera> cameraR = createCamera(AffineSpace3f(camSpaceR.l,camSpaceR.p), 1, 0, 0, 0.5f*g_width/(float)g_height);
 
-    /* render into framebuffer */
-    g_device->rtRenderFrame(g_renderer,cameraL,g_render_scene,g_tonemapper,g_frameBuffer0,accumulate);
-
-    g_device->rtRenderFrame(g_renderer,cameraR,g_render_scene,g_tonemapper,g_frameBuffer1,accumulate);
+    /* render both eyes side by side into one framebuffer, the eyes are offset along the camera x axis */
+    if (g_stereoSinglePass)
+    {
+      AffineSpace3f camSpace = AffineSpace3f::lookAtPoint(g_camPos, g_camLookAt, g_camUp);
+      Handle<Device::RTCamera> camera = createStereoCamera(camSpace, scale*g_stereoOffset, 0.5f*g_width/(float)g_height);
+      g_device->rtRenderFrameAsync(g_renderer,camera,g_render_scene,g_tonemapper,g_frameBuffer0,g_frameAccumulate,&g_frameCancel);
+    }
+    else
+    {
+      Vector3f camPosL = g_camPos + Vector3f(-scale*g_stereoOffset/2.0, 0.0, 0.0);
+      Vector3f camLookAtL = g_camLookAt + Vector3f(-scale*g_stereoOffset/2.0, 0.0, 0.0);
+      AffineSpace3f camSpaceL = AffineSpace3f::lookAtPoint(camPosL, camLookAtL, g_camUp);
+
+      Vector3f camPosR = g_camPos + Vector3f(scale*g_stereoOffset/2.0, 0.0, 0.0);
+      Vector3f camLookAtR = g_camLookAt + Vector3f(scale*g_stereoOffset/2.0, 0.0, 0.0);
+      AffineSpace3f camSpaceR = AffineSpace3f::lookAtPoint(camPosR, camLookAtR, g_camUp);
+
+      /* render left eye, the right eye follows once it is ready */
+      Handle<Device::RTCamera> cameraL = createCamera(AffineSpace3f(camSpaceL.l, camSpaceL.p), 0, 0, g_stereoPixelMargin, 0.5f*g_width/(float)g_height);
+      g_frameCameraR = createCamera(AffineSpace3f(camSpaceR.l,camSpaceR.p), 1, 0, 0, 0.5f*g_width/(float)g_height);
+      g_device->rtRenderFrameAsync(g_renderer,cameraL,g_render_scene,g_tonemapper,g_frameBuffer0,g_frameAccumulate,&g_frameCancel);
+    }
+    g_framePass = 0;
+  }
 
+  static void presentFrame()
+  {
     g_device->rtSwapBuffers(g_frameBuffer0);
-    g_device->rtSwapBuffers(g_frameBuffer1);
+    if (!g_stereoSinglePass) g_device->rtSwapBuffers(g_frameBuffer1);
+
+    g_renderTime = 1000.0*(getSeconds()-g_frameStart);
+    std::cout << "stereo " << (g_stereoSinglePass ? "single pass" : "two passes") << ": " << g_renderTime << " ms" << std::endl;
 
     /* draw image in OpenGL */
     double render_t0 = getSeconds();
@@ -1292,9 +1407,15 @@ namespace embree
     }
 #else
 
-    UpdateTex(g_renderConfig.renderToTexID[0], (unsigned char*)g_device->rtMapFrameBuffer(g_frameBuffer0), g_width/2+g_stereoPixelMargin, g_height);
-
-    UpdateTex(g_renderConfig.renderToTexID[1], (unsigned char*)g_device->rtMapFrameBuffer(g_frameBuffer1), g_width/2+g_stereoPixelMargin, g_height);
+    if (g_stereoSinglePass) {
+      unsigned char* ptr = (unsigned char*)g_device->rtMapFrameBuffer(g_frameBuffer0);
+      UpdateTex(g_renderConfig.renderToTexID[0], ptr, g_renderWidth/2, g_renderHeight, g_renderWidth);
+      UpdateTex(g_renderConfig.renderToTexID[1], ptr + 4*(g_renderWidth/2), g_renderWidth/2, g_renderHeight, g_renderWidth);
+    } 
+    else {
+      UpdateTex(g_renderConfig.renderToTexID[0], (unsigned char*)g_device->rtMapFrameBuffer(g_frameBuffer0), g_renderWidth/2+g_stereoPixelMargin, g_renderHeight);
+      UpdateTex(g_renderConfig.renderToTexID[1], (unsigned char*)g_device->rtMapFrameBuffer(g_frameBuffer1), g_renderWidth/2+g_stereoPixelMargin, g_renderHeight);
+    }
 
     assert(g_format == "RGBA8");
 
@@ -1306,7 +1427,7 @@ namespace embree
     glutSwapBuffers();
 
     g_device->rtUnmapFrameBuffer(g_frameBuffer0);
-    g_device->rtUnmapFrameBuffer(g_frameBuffer1);
+    if (!g_stereoSinglePass) g_device->rtUnmapFrameBuffer(g_frameBuffer1);
 
     double render_t1 = getSeconds();
 
@@ -1332,12 +1453,43 @@ namespace embree
     stream.precision(2);
     stream << dt*1000.0f << " ms";
     stream << ", " << g_width << "x" << g_height;
+    if (g_renderScale < 1.0f) stream << " (" << g_renderWidth << "x" << g_renderHeight << ")";
     if (log_display)
       std::cout << "display " << stream.str() << std::endl;
     glutSetWindowTitle((std::string("Embree: ") + stream.str()).c_str());
 
     std::cout << "glrender: " << render_t1 - render_t0 << " secs" << std::endl;
+  }
+
+  void displayFunc(void)
+  {
+    if (g_pause)
+      return;
 
+    /* new input outdates the frame in flight, it stops before its next tile. A frame is only
+     * cancelled when the previous one got presented, thus continuous input still shows every
+     * other frame. */
+    if (g_framePass >= 0)
+    {
+      if (g_resetAccumulation && !g_frameDropped) g_frameCancel = 1;
+      if (!g_device->rtFrameReady(frameTarget())) return;
+
+      if (g_frameCancel) {
+        g_frameDropped = true;
+      }
+      else if (g_framePass == 0 && !g_stereoSinglePass) {
+        g_device->rtRenderFrameAsync(g_renderer,g_frameCameraR,g_render_scene,g_tonemapper,g_frameBuffer1,g_frameAccumulate,&g_frameCancel);
+        g_framePass = 1;
+        return;
+      }
+      else {
+        presentFrame();
+        g_frameDropped = false;
+      }
+      g_framePass = -1;
+    }
+
+    startFrame();
   }
 
   void reshapeFunc(int w, int h) {
@@ -1355,8 +1507,8 @@ namespace embree
     //g_renderConfig.width = g_width;
 
     // @syoyo: 
-    g_frameBuffer0 = g_device->rtNewFrameBuffer(g_format.c_str(),w/2+g_stereoPixelMargin,h,g_numBuffers);
-    g_frameBuffer1 = g_device->rtNewFrameBuffer(g_format.c_str(),w/2,h,g_numBuffers);
+    abortFrame();
+    resizeRenderTarget();
     glViewport(0, 0, (GLsizei)g_width, (GLsizei)g_height);
     g_resetAccumulation = true;
   }
@@ -1488,6 +1640,9 @@ namespace embree
     //}
     //glutSetCursor(GLUT_CURSOR_NONE);
 
+    /* the distortion camera renders the lens distortion already, thus the post process only displays the image */
+    if (g_camDistortion) gApplyDistortion = 0.0f;
+
     // @syoyo
     InitRenderConfig(g_renderConfig, g_width/2, g_height, g_stereoPixelMargin);
     PreparePostProcessShader(g_renderConfig);
@@ -14,9 +14,14 @@
 // limitations under the License.                                           //
 // ======================================================================== //
 
+#include <deque>
 #include "sys/platform.h"
 #include "sys/filename.h"
+#include "sys/thread.h"
+#include "sys/sync/mutex.h"
+#include "sys/sync/condition.h"
 #include "image/image.h"
+#include "image/compressed.h"
 #include "lexers/streamfilters.h"
 #include "lexers/parsestream.h"
 #include "device/loaders/loaders.h"
@@ -34,6 +39,16 @@ namespace embree
   Vector3f g_camUp     = Vector3f(0,1,0);
   float g_camFieldOfView = 75.0f; // @syoyo: Oculus. // 64
   float g_camRadius = 0.0f;
+  bool g_camDistortion = false;            //!< render the HMD lens distortion directly instead of resampling
+  bool g_camChromatic = false;             //!< trace one primary ray per color channel for chromatic aberration
+  bool g_stereoSinglePass = false;         //!< render both eyes in one pass with a stereo camera
+
+  /*! camera of one frame of a sequence rendered in output mode */
+  struct View {
+    Vector3f pos, lookAt, up;
+    float fieldOfView;
+  };
+  std::vector<View> g_views;               //!< camera sequence, a single frame of the current camera if empty
 
   /* rendering device and global handles */
   Handle<Device::RTRenderer> g_renderer = NULL;
@@ -58,6 +73,8 @@ namespace embree
   std::string g_traverser = "default";
   int g_depth = -1;                       //!< recursion depth
   int g_spp = 1;                          //!< samples per pixel for ordinary rendering
+  float g_frameBudget = 0.0f;             //!< target frame time in milliseconds of interactive rendering, 0 disables it
+  int g_reprojection = 0;                 //!< maximal samples per pixel reprojected on camera changes, 0 disables it
 
   /* output settings */
   int g_numBuffers = 2;                   //!< number of buffers of the framebuffer
@@ -72,7 +89,7 @@ namespace embree
   std::string g_format = "RGBA8";
   std::string g_rtcore_cfg = "";
   std::string g_outFileName = "";
-  size_t g_num_frames = 1; // number of frames to render in output mode
+  size_t g_num_frames = 1; // number of frames to accumulate per image in output mode
   size_t g_numThreads = 0;
   size_t g_verbose_output = 0;
 
@@ -89,10 +106,10 @@ namespace embree
 
   Handle<Device::RTCamera> createCamera(const AffineSpace3f& space, int stereoTy = 0, float stereoDistance = 0.0f, int stereoPixelMargin = 0, float aspectRatio = 1.0)
   {
-    /*! pinhole camera */
+    /*! pinhole camera, optionally with the lens distortion of the HMD */
     if (g_camRadius == 0.0f)
     {
-      Handle<Device::RTCamera> camera = g_device->rtNewCamera("pinhole");
+      Handle<Device::RTCamera> camera = g_device->rtNewCamera(g_camDistortion ? "distortion" : "pinhole");
       g_device->rtSetTransform(camera, "local2world", copyToArray(space));
       g_device->rtSetFloat1(camera, "angle", g_camFieldOfView);
       g_device->rtSetInt1(camera, "stereoType", stereoTy);
@@ -100,6 +117,7 @@ namespace embree
       g_device->rtSetFloat1(camera, "stereoDistance", stereoDistance);
       //g_device->rtSetFloat1(camera, "aspectRatio", float(0.5f*g_width) / float(g_height)); // stereo
       g_device->rtSetFloat1(camera, "aspectRatio", aspectRatio); // stereo
+      if (g_camDistortion) g_device->rtSetBool1(camera, "chromatic", g_camChromatic);
       g_device->rtCommit(camera);
       return camera;
     }
@@ -118,6 +136,20 @@ namespace embree
     }
   }
 
+  /*! stereo camera rendering both eyes side by side in one pass */
+  Handle<Device::RTCamera> createStereoCamera(const AffineSpace3f& space, float stereoDistance, float aspectRatio)
+  {
+    Handle<Device::RTCamera> camera = g_device->rtNewCamera("stereo");
+    g_device->rtSetTransform(camera, "local2world", copyToArray(space));
+    g_device->rtSetFloat1(camera, "angle", g_camFieldOfView);
+    g_device->rtSetFloat1(camera, "stereoDistance", stereoDistance);
+    g_device->rtSetFloat1(camera, "aspectRatio", aspectRatio); // of one eye
+    g_device->rtSetBool1(camera, "distortion", g_camDistortion);
+    g_device->rtSetBool1(camera, "chromatic", g_camChromatic);
+    g_device->rtCommit(camera);
+    return camera;
+  }
+
   Handle<Device::RTScene> createScene()
   {
     Handle<Device::RTScene> scene = g_device->rtNewScene(g_scene.c_str());
@@ -136,11 +168,18 @@ namespace embree
     g_device->rtCommit(g_render_scene);
   }
 
+  /*! returns the budget of one rtRenderFrame call, two pass stereo renders each eye with its own call */
+  static float frameBudgetPerPass() {
+    return g_stereoSinglePass ? g_frameBudget : 0.5f*g_frameBudget;
+  }
+
   void createGlobalObjects()
   {
     g_renderer = g_device->rtNewRenderer("pathtracer");
     if (g_depth >= 0) g_device->rtSetInt1(g_renderer, "maxDepth", g_depth);
     g_device->rtSetInt1(g_renderer, "sampler.spp", g_spp);
+    g_device->rtSetFloat1(g_renderer, "frameBudget", frameBudgetPerPass());
+    g_device->rtSetInt1(g_renderer, "reprojection", g_reprojection);
 
     // @syoyo
     g_device->rtSetString(g_renderer, "samplermapfile", g_sampleMapFile.c_str());
@@ -200,6 +239,8 @@ namespace embree
     g_renderer = g_device->rtNewRenderer("pathtracer");
     if (g_depth >= 0) g_device->rtSetInt1(g_renderer, "maxDepth", g_depth);
     g_device->rtSetInt1(g_renderer, "sampler.spp", g_spp);
+    g_device->rtSetFloat1(g_renderer, "frameBudget", frameBudgetPerPass());
+    g_device->rtSetInt1(g_renderer, "reprojection", g_reprojection);
     if (g_backplate) g_device->rtSetImage(g_renderer, "backplate", g_backplate);
 
     if (cin->peek() != "{") goto finish;
@@ -211,7 +252,11 @@ namespace embree
       if      (tag == "depth"          ) g_device->rtSetInt1  (g_renderer, "maxDepth"       , cin->getInt()  );
       else if (tag == "spp"            ) g_device->rtSetInt1  (g_renderer, "sampler.spp"    , cin->getInt()  );
       else if (tag == "minContribution") g_device->rtSetFloat1(g_renderer, "minContribution", cin->getFloat());
+      else if (tag == "sampler"        ) g_device->rtSetString(g_renderer, "sampler"        , cin->getString().c_str());
       else if (tag == "backplate"      ) g_device->rtSetImage (g_renderer, "backplate", rtLoadImage(path + cin->getFileName()));
+      else if (tag == "shadowCache"    ) g_device->rtSetFloat1(g_renderer, "shadowCache"    , cin->getFloat());
+      else if (tag == "guiding"        ) g_device->rtSetInt1  (g_renderer, "guiding"        , cin->getInt()  );
+      else if (tag == "firstHitCache"  ) g_device->rtSetInt1  (g_renderer, "firstHitCache"  , cin->getInt()  );
       else std::cout << "unknown tag \"" << tag << "\" in debug renderer parsing" << std::endl;
     }
     cin->drop();
@@ -230,30 +275,123 @@ namespace embree
     g_rendered = true;
   }
 
-  static void outputMode(const FileName& fileName)
+  /*! Stores images on a background thread, thus encoding and writing
+   *  an image overlaps rendering of the next one. */
+  class ImageWriter
   {
-    if (!g_renderer) throw std::runtime_error("no renderer set");
+    /*! maximal number of images waiting to be stored */
+    enum { MAX_QUEUED = 2 };
 
-    /* render image */
-    Handle<Device::RTCamera> camera = createCamera(AffineSpace3f::lookAtPoint(g_camPos, g_camLookAt, g_camUp));
-    Handle<Device::RTScene> scene = createScene();
-    g_device->rtSetInt1(g_renderer, "showprogress", 1);
-    g_device->rtCommit(g_renderer);
-    for (size_t i=0; i<g_num_frames; i++)
-      g_device->rtRenderFrame(g_renderer, camera, scene, g_tonemapper, g_frameBuffer0, 0);
-    for (int i=0; i<g_numBuffers; i++)
-      g_device->rtSwapBuffers(g_frameBuffer0);
-    
-    /* store to disk */
+  public:
+
+    ImageWriter () : terminate(false) {
+      thread = createThread(run,this);
+    }
+
+    /*! stores all pending images and stops the thread */
+    ~ImageWriter () 
+    {
+      {
+        Lock<MutexSys> lock(mutex);
+        terminate = true;
+        condition.broadcast();
+      }
+      join(thread);
+    }
+
+    /*! queues an image for storing, blocks while too many images are pending */
+    void push(const Ref<Image>& image, const FileName& fileName)
+    {
+      Lock<MutexSys> lock(mutex);
+      while (queue.size() >= MAX_QUEUED) condition.wait(mutex);
+      queue.push_back(std::pair<Ref<Image>,FileName>(image,fileName));
+      condition.broadcast();
+    }
+
+  private:
+
+    static void run(void* ptr) {
+      ((ImageWriter*)ptr)->run();
+    }
+
+    void run()
+    {
+      while (true)
+      {
+        std::pair<Ref<Image>,FileName> job;
+        {
+          Lock<MutexSys> lock(mutex);
+          while (queue.empty() && !terminate) condition.wait(mutex);
+          if (queue.empty()) return;
+          job = queue.front(); queue.pop_front();
+          condition.broadcast();
+        }
+        try {
+          storeImage(job.first, job.second);
+        } catch (const std::exception& e) {
+          std::cerr << "cannot store " << job.second << ": " << e.what() << std::endl;
+        }
+      }
+    }
+
+  private:
+    thread_t thread;                                     //!< the writer thread
+    MutexSys mutex;                                      //!< protects the queue
+    ConditionSys condition;                              //!< signals changes of the queue
+    std::deque<std::pair<Ref<Image>,FileName> > queue;  //!< images waiting to be stored
+    bool terminate;                                      //!< set when no more images follow
+  };
+
+  /*! copies the current framebuffer into an image */
+  static Ref<Image> copyFrameBuffer()
+  {
     void* ptr = g_device->rtMapFrameBuffer(g_frameBuffer0);
     Ref<Image> image = null;
     if      (g_format == "RGB8"        )  image = new Image3c(g_width, g_height, (Col3c*)ptr); 
     else if (g_format == "RGBA8"       )  image = new Image4c(g_width, g_height, (Col4c*)ptr);
     else if (g_format == "RGB_FLOAT32" )  image = new Image3f(g_width, g_height, (Col3f*)ptr); 
     else if (g_format == "RGBA_FLOAT32")  image = new Image4f(g_width, g_height, (Col4f*)ptr);
-    else throw std::runtime_error("unsupported framebuffer format: "+g_format);
-    storeImage(image, fileName);
+    else if (g_format == "RGBA_HALF16" )  image = new ImageHalf(g_width, g_height, (unsigned short*)ptr);
     g_device->rtUnmapFrameBuffer(g_frameBuffer0);
+    if (!image) throw std::runtime_error("unsupported framebuffer format: "+g_format);
+    return image;
+  }
+
+  static void outputMode(const FileName& fileName)
+  {
+    if (!g_renderer) throw std::runtime_error("no renderer set");
+
+    /* render a single frame of the current camera if no sequence is given */
+    std::vector<View> views = g_views;
+    if (views.empty()) {
+      View view; view.pos = g_camPos; view.lookAt = g_camLookAt; view.up = g_camUp; view.fieldOfView = g_camFieldOfView;
+      views.push_back(view);
+    }
+
+    Handle<Device::RTScene> scene = createScene();
+    g_device->rtSetInt1(g_renderer, "showprogress", 1);
+    g_device->rtCommit(g_renderer);
+
+    /* images are stored while the next one renders */
+    ImageWriter writer;
+    for (size_t v=0; v<views.size(); v++)
+    {
+      /* render image, accumulating all its frames */
+      g_camFieldOfView = views[v].fieldOfView;
+      Handle<Device::RTCamera> camera = createCamera(AffineSpace3f::lookAtPoint(views[v].pos, views[v].lookAt, views[v].up));
+      for (size_t i=0; i<g_num_frames; i++)
+        g_device->rtRenderFrame(g_renderer, camera, scene, g_tonemapper, g_frameBuffer0, i > 0);
+      for (int i=0; i<g_numBuffers; i++)
+        g_device->rtSwapBuffers(g_frameBuffer0);
+
+      /* sequences get numbered file names */
+      FileName name = fileName;
+      if (views.size() > 1) {
+        char postfix[32]; sprintf(postfix,".%04d.",int(v));
+        name = fileName.setExt(postfix+fileName.ext());
+      }
+      writer.push(copyFrameBuffer(), name);
+    }
     g_rendered = true;
   }
 
@@ -471,21 +609,18 @@ namespace embree
         Vector3f V = cin->getVector3f();
         Vector3f L = cin->getVector3f();
 
-        Handle<Device::RTLight> light0 = g_device->rtNewLight("trianglelight");
-        g_device->rtSetFloat3(light0, "v0", P.x + U.x + V.x, P.y + U.y + V.y, P.z + U.z + V.z);
-        g_device->rtSetFloat3(light0, "v1", P.x + U.x, P.y + U.y, P.z + U.z);
-        g_device->rtSetFloat3(light0, "v2", P.x, P.y, P.z);
-        g_device->rtSetFloat3(light0, "L",  L.x, L.y, L.z);
-        g_device->rtCommit(light0);
-        g_prims.push_back(g_device->rtNewLightPrimitive(light0, NULL, NULL));
+        /*! both triangles share one mesh light, thus a single sample covers the whole quad */
+        Vector3f positions[4] = { P+U+V, P+U, P, P+V };
+        Vector3i indices[2] = { Vector3i(0,1,2), Vector3i(0,2,3) };
+        Handle<Device::RTData> dataPositions = g_device->rtNewData("immutable", sizeof(positions), positions);
+        Handle<Device::RTData> dataIndices   = g_device->rtNewData("immutable", sizeof(indices), indices);
 
-        Handle<Device::RTLight> light1 = g_device->rtNewLight("trianglelight");
-        g_device->rtSetFloat3(light1, "v0", P.x + U.x + V.x, P.y + U.y + V.y, P.z + U.z + V.z);
-        g_device->rtSetFloat3(light1, "v1", P.x, P.y, P.z);
-        g_device->rtSetFloat3(light1, "v2", P.x + V.x, P.y + V.y, P.z + V.z);
-        g_device->rtSetFloat3(light1, "L",  L.x, L.y, L.z);
-        g_device->rtCommit(light1);
-        g_prims.push_back(g_device->rtNewLightPrimitive(light1, NULL, NULL));
+        Handle<Device::RTLight> light = g_device->rtNewLight("meshlight");
+        g_device->rtSetArray(light, "positions", "float3", dataPositions, 4, sizeof(Vector3f), 0);
+        g_device->rtSetArray(light, "indices"  , "int3"  , dataIndices  , 2, sizeof(Vector3i), 0);
+        g_device->rtSetFloat3(light, "L",  L.x, L.y, L.z);
+        g_device->rtCommit(light);
+        g_prims.push_back(g_device->rtNewLightPrimitive(light, NULL, NULL));
       }
 
       /* HDRI light source */
@@ -507,6 +642,13 @@ namespace embree
       else if (tag == "-angle")  g_camFieldOfView = cin->getFloat();
       else if (tag == "-fov")    g_camFieldOfView = cin->getFloat();
       else if (tag == "-radius") g_camRadius      = cin->getFloat();
+      else if (tag == "-distortion") g_camDistortion = true;
+      else if (tag == "-chromatic") g_camDistortion = g_camChromatic = true;
+      else if (tag == "-singlepass") {
+        g_stereoSinglePass = true;
+        g_device->rtSetFloat1(g_renderer, "frameBudget", frameBudgetPerPass());
+        g_device->rtCommit(g_renderer);
+      }
       else if (tag == "-redis_host") g_redisHostname = cin->getString();
       else if (tag == "-redis_port") g_redisPort = cin->getInt();
       else if (tag == "-nohmd") g_hmd = false;
@@ -583,16 +725,43 @@ namespace embree
         g_device->rtCommit(g_renderer);
       }
 
+      /* set the frame time to hold in interactive mode */
+      else if (tag == "-framebudget") {
+        g_frameBudget = cin->getFloat();
+        g_device->rtSetFloat1(g_renderer, "frameBudget", frameBudgetPerPass());
+        g_device->rtCommit(g_renderer);
+      }
+
+      /* reproject the accumulation when the camera moves */
+      else if (tag == "-reproject") {
+        g_device->rtSetInt1(g_renderer, "reprojection", g_reprojection = cin->getInt());
+        g_device->rtCommit(g_renderer);
+      }
+
       /* set the backplate */
       else if (tag == "-backplate") {
         g_device->rtSetImage(g_renderer, "backplate", g_backplate = rtLoadImage(path + cin->getFileName()));
         g_device->rtCommit(g_renderer);
       }
 
-      /* number of frames to render in output mode (used for benchmarking) */
+      /* set the byte budget of the texture tile cache */
+      else if (tag == "-texturecache")
+        g_device->rtSetInt1(NULL, "textureCacheSize", cin->getInt());
+
+      /* set the in-memory storage format of textures loaded afterwards */
+      else if (tag == "-texturecompression")
+        g_device->rtSetString(NULL, "imageCompression", cin->getString().c_str());
+
+      /* number of frames to accumulate per image in output mode (used for benchmarking) */
       else if (tag == "-frames") 
         g_num_frames = cin->getInt();
 
+      /* appends the current camera to the sequence rendered in output mode */
+      else if (tag == "-keyframe") {
+        View view; view.pos = g_camPos; view.lookAt = g_camLookAt; view.up = g_camUp; view.fieldOfView = g_camFieldOfView;
+        g_views.push_back(view);
+      }
+
       /* render frame */
       else if (tag == "-o") {
         std::string fn = cin->getFileName();
@@ -645,6 +814,13 @@ namespace embree
         std::cout << "-o file" << std::endl;
         std::cout << "  Renders and outputs the image to the file." << std::endl;
         std::cout << std::endl;
+        std::cout << "-frames N" << std::endl;
+        std::cout << "  Accumulates N frames per output image." << std::endl;
+        std::cout << std::endl;
+        std::cout << "-keyframe" << std::endl;
+        std::cout << "  Appends the current camera (-vp, -vi, -vu, -fov) to the sequence" << std::endl;
+        std::cout << "  of images rendered to numbered files with -o." << std::endl;
+        std::cout << std::endl;
         std::cout << "-display" << std::endl;
         std::cout << "  Interactively displays the rendering into a window." << std::endl;
         std::cout << std::endl;
@@ -663,6 +839,15 @@ namespace embree
         std::cout << "-fov angle" << std::endl;
         std::cout << "  Sets camera field of view in y direction to angle." << std::endl;
         std::cout << std::endl;
+        std::cout << "-distortion" << std::endl;
+        std::cout << "  Renders the HMD lens distortion directly, the image gets displayed without resampling." << std::endl;
+        std::cout << std::endl;
+        std::cout << "-chromatic" << std::endl;
+        std::cout << "  Like -distortion, but traces one ray per color channel for chromatic aberration." << std::endl;
+        std::cout << std::endl;
+        std::cout << "-singlepass" << std::endl;
+        std::cout << "  Renders both eyes side by side in one pass with a stereo camera (singleray device only)." << std::endl;
+        std::cout << std::endl;
         std::cout << "-size width height" << std::endl;
         std::cout << "  Sets the width and height of image to render." << std::endl;
         std::cout << std::endl;
@@ -681,9 +866,23 @@ namespace embree
         std::cout << "-spp i" << std::endl;
         std::cout << "  Sets the number of samples per pixel to i (default 1) (only pathtracer)." << std::endl;
         std::cout << std::endl;
+        std::cout << "-framebudget ms" << std::endl;
+        std::cout << "  Holds the frame time in display mode by lowering the samples per pixel and the" << std::endl;
+        std::cout << "  render resolution while the camera moves, refines once it stops (default 0, off)." << std::endl;
+        std::cout << std::endl;
+        std::cout << "-reproject i" << std::endl;
+        std::cout << "  Reprojects the accumulated image into the new view when the camera moves, keeping" << std::endl;
+        std::cout << "  up to i samples per pixel of the history (default 0, off) (only pathtracer)." << std::endl;
+        std::cout << std::endl;
         std::cout << "-backplate" << std::endl;
         std::cout << "  Sets a high resolution back ground image. (default none) (only pathtracer)." << std::endl;
         std::cout << std::endl;
+        std::cout << "-texturecache MB" << std::endl;
+        std::cout << "  Sets the memory budget for tiles of .etx textures (default 1024)." << std::endl;
+        std::cout << std::endl;
+        std::cout << "-texturecompression none|auto|bc1|rgb9e5|half" << std::endl;
+        std::cout << "  Stores textures loaded afterwards in a compressed format (default none)." << std::endl;
+        std::cout << std::endl;
 
         std::cout << "-ambientlight r g b" << std::endl;
         std::cout << "  Creates an ambient light with intensity (r,g,b)." << std::endl;
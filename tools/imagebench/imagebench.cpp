@@ -0,0 +1,111 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "image/image.h"
+#include "sys/filename.h"
+#include "sys/sysinfo.h"
+#include "sys/taskscheduler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+namespace embree
+{
+  /*! creates a smooth test image with some high frequency detail */
+  Ref<Image> createTestImage(size_t width, size_t height, bool hdr)
+  {
+    Ref<Image> img;
+    if (hdr) img = new Image3f(width,height,"test");
+    else     img = new Image3c(width,height,"test");
+    for (size_t y=0; y<height; y++) {
+      for (size_t x=0; x<width; x++) {
+        const float fx = float(x)/float(width), fy = float(y)/float(height);
+        const float d = ((x^y)&15)/64.0f;
+        img->set(x,y,Color4(fx,fy,clamp(1.0f-fx*fy+d),1.0f));
+      }
+    }
+    return img;
+  }
+
+  /*! measures store and load time of one format */
+  void benchmark(const std::string& ext, size_t width, size_t height, size_t repeats, const FileName& dir)
+  {
+    const bool hdr = ext == "pfm" || ext == "exr";
+    Ref<Image> img = createTestImage(width,height,hdr);
+    FileName fileName = dir + ("imagebench." + ext);
+    const double mpixels = double(width*height)*1E-6;
+
+    double tstore = inf, tload = inf;
+    for (size_t i=0; i<repeats; i++) 
+    {
+      double t0 = getSeconds();
+      storeImage(img,fileName);
+      double t1 = getSeconds();
+      Ref<Image> img1 = loadImage(fileName);
+      double t2 = getSeconds();
+      if (!img1) { printf("  %-4s  not supported\n",ext.c_str()); return; }
+      tstore = min(tstore,t1-t0);
+      tload  = min(tload ,t2-t1);
+    }
+    remove(fileName.c_str());
+
+    printf("  %-4s  %zux%zu  store %8.2f ms (%7.1f Mpix/s)  load %8.2f ms (%7.1f Mpix/s)\n",
+           ext.c_str(), width, height, 1000.0*tstore, mpixels/tstore, 1000.0*tload, mpixels/tload);
+  }
+}
+
+int main(int argc, char **argv) 
+{
+  size_t repeats = 3, threads = embree::getNumberOfLogicalThreads();
+  std::string dir = ".";
+  std::vector<std::string> formats;
+  std::vector<std::pair<size_t,size_t> > sizes;
+
+  for (int i=1; i<argc; i++) {
+    if      (!strcmp(argv[i],"-size"   ) && i+2 < argc) { size_t w = atoi(argv[++i]); size_t h = atoi(argv[++i]); sizes.push_back(std::make_pair(w,h)); }
+    else if (!strcmp(argv[i],"-repeats") && i+1 < argc) repeats = atoi(argv[++i]);
+    else if (!strcmp(argv[i],"-threads") && i+1 < argc) threads = atoi(argv[++i]);
+    else if (!strcmp(argv[i],"-dir"    ) && i+1 < argc) dir = argv[++i];
+    else if (argv[i][0] != '-') formats.push_back(argv[i]);
+    else printf("  USAGE:  imagebench [-size <width> <height>]* [-repeats <n>] [-threads <n>] [-dir <path>] [formats ...]\n"), exit(1);
+  }
+
+  /*! by default benchmark all formats of common/image */
+  if (formats.empty()) {
+    const char* all[] = { "ppm", "pfm", "tga", "jpg", "exr", "png", "bmp", "tif" };
+    formats.assign(all,all+sizeof(all)/sizeof(all[0]));
+  }
+
+  /*! by default benchmark HD, 4K, and 8K images */
+  if (sizes.empty()) {
+    sizes.push_back(std::make_pair(size_t(1920),size_t(1080)));
+    sizes.push_back(std::make_pair(size_t(3840),size_t(2160)));
+    sizes.push_back(std::make_pair(size_t(7680),size_t(4320)));
+  }
+
+  /*! encoders split their work into strips executed by the task scheduler */
+  if (threads > 1) embree::TaskScheduler::create(threads);
+  printf("  %zu encoder threads\n",threads > 1 ? threads : size_t(1));
+
+  for (size_t i=0; i<formats.size(); i++)
+    for (size_t j=0; j<sizes.size(); j++)
+      embree::benchmark(formats[i],sizes[j].first,sizes[j].second,repeats,dir + "/");
+
+  if (threads > 1) embree::TaskScheduler::destroy();
+  return 0;
+}
@@ -0,0 +1,53 @@
+// ======================================================================== //
+// Copyright 2009-2013 Intel Corporation                                    //
+//                                                                          //
+// Licensed under the Apache License, Version 2.0 (the "License");          //
+// you may not use this file except in compliance with the License.         //
+// You may obtain a copy of the License at                                  //
+//                                                                          //
+//     http://www.apache.org/licenses/LICENSE-2.0                           //
+//                                                                          //
+// Unless required by applicable law or agreed to in writing, software      //
+// distributed under the License is distributed on an "AS IS" BASIS,        //
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. //
+// See the License for the specific language governing permissions and      //
+// limitations under the License.                                           //
+// ======================================================================== //
+
+#include "image/image.h"
+#include "image/tiled.h"
+#include "sys/filename.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <iostream>
+
+/*! converts images into tiled, mip-mapped .etx files for paged textures */
+int main(int argc, char **argv) 
+{
+  using namespace embree;
+  size_t tileSize = 64;
+  std::vector<std::string> files;
+
+  for (int i=1; i<argc; i++) {
+    if (!strcmp(argv[i],"-tile") && i+1 < argc) tileSize = atoi(argv[++i]);
+    else if (argv[i][0] != '-') files.push_back(argv[i]);
+    else files.clear(), i = argc;
+  }
+  if (files.size() != 2) {
+    printf("  USAGE:  maketiled [-tile <size>] <input image> <output.etx>\n");
+    return 1;
+  }
+
+  try {
+    Ref<Image> image = loadImage(FileName(files[0]));
+    if (!image) return 1;
+    storeTiled(image,FileName(files[1]),tileSize);
+  }
+  catch (const std::exception& e) {
+    std::cout << "Error: " << e.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}